@@ -1,20 +1,25 @@
 #pragma once
 
+#include <cstdint>
 #include "geo.h"
-#include <string>
+#include <limits>
+#include <optional>
+#include <string_view>
 #include <vector>
 
 namespace transport_catalogue {
     namespace domain {
 
-        struct Stop {
-            std::string name;
-            geo::Coordinates coordinates;
-        };
+        // Номер остановки в порядке добавления в справочник. Название и координаты остановки хранятся в справочнике
+        using StopId = std::uint32_t;
+
+        // Номер автобуса в порядке добавления в справочник
+        using BusIndex = std::uint32_t;
 
         struct Bus {
-            std::string name;
-            std::vector<const Stop*> stops;
+            // название хранится в хранилище имён справочника
+            std::string_view name;
+            std::vector<StopId> stops;
             bool is_roundtrip;
         };
 
@@ -24,6 +29,41 @@ namespace transport_catalogue {
             int route_length;
             double route_curvature;
         };
+
+        // Поле RouteInfo в отчётах по автобусам
+        enum class BusStatField {
+            STOP_COUNT,
+            UNIQUE_STOP_COUNT,
+            ROUTE_LENGTH,
+            CURVATURE
+        };
+
+        // Отбирает автобусы со значением поля из [min, max]. У автобуса нулевой геодлины нет извилистости,
+        // и фильтры по ней он не проходит даже без границ
+        struct BusStatFilter {
+            BusStatField field;
+            double min = -std::numeric_limits<double>::infinity();
+            double max = std::numeric_limits<double>::infinity();
+        };
+
+        struct BusStatsQuery {
+            std::vector<BusStatFilter> filters;
+            // без sort_by отчёт содержит только количество и суммы
+            std::optional<BusStatField> sort_by;
+            bool is_ascending = false;
+            size_t limit = 10;
+        };
+
+        // Количество автобусов, прошедших все фильтры, суммы их значений и первые limit из них
+        // в порядке sort_by, при равных значениях — в порядке названий. Автобусы без значения поля идут последними
+        // в обоих порядках, между собой — в порядке названий
+        struct BusStatsReport {
+            size_t bus_count = 0;
+            std::int64_t total_stops_number = 0;
+            std::int64_t unique_stops_number = 0;
+            std::int64_t route_length = 0;
+            std::vector<BusIndex> buses;
+        };
         
     } // namespace domain
 } // namespace transport_catalogue
\ No newline at end of file
@@ -1,4 +1,5 @@
 #define _USE_MATH_DEFINES
+#include <algorithm>
 #include <cmath>
 #include "geo.h"
 
@@ -17,7 +18,48 @@ namespace transport_catalogue {
             const double dr = M_PI / 180.0;
             return acos(sin(from.lat * dr) * sin(to.lat * dr)
                         + cos(from.lat * dr) * cos(to.lat * dr) * cos(abs(from.lng - to.lng) * dr))
-                * 6371000;
+                * EARTH_RADIUS;
+        }
+
+        void SpherePoints::Reserve(size_t count) {
+            x_.reserve(count);
+            y_.reserve(count);
+            z_.reserve(count);
+        }
+
+        void SpherePoints::Add(Coordinates coordinates) {
+            x_.push_back(0);
+            y_.push_back(0);
+            z_.push_back(0);
+            Set(static_cast<std::uint32_t>(x_.size() - 1), coordinates);
+        }
+
+        void SpherePoints::Set(std::uint32_t index, Coordinates coordinates) {
+            using namespace std;
+            const double dr = M_PI / 180.0;
+            const double cos_lat = cos(coordinates.lat * dr);
+            x_[index] = cos_lat * cos(coordinates.lng * dr);
+            y_[index] = cos_lat * sin(coordinates.lng * dr);
+            z_[index] = sin(coordinates.lat * dr);
+        }
+
+        double SpherePoints::ComputePathLength(const std::uint32_t* path_begin, const std::uint32_t* path_end) const {
+            double dots[BATCH_SIZE];
+            double result = 0;
+            while (path_end - path_begin > 1) {
+                const size_t count = std::min<size_t>(BATCH_SIZE, path_end - path_begin - 1);
+                for (size_t i = 0; i < count; ++i) {
+                    const std::uint32_t from = path_begin[i];
+                    const std::uint32_t to = path_begin[i + 1];
+                    dots[i] = x_[from] * x_[to] + y_[from] * y_[to] + z_[from] * z_[to];
+                }
+                // из-за округления произведение совпадающих точек может немного превысить 1
+                for (size_t i = 0; i < count; ++i) {
+                    result += std::acos(std::clamp(dots[i], -1.0, 1.0));
+                }
+                path_begin += count;
+            }
+            return result * EARTH_RADIUS;
         }
 
     }  // namespace geo
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <cmath>
+#include <cstdint>
+#include <vector>
 
 namespace transport_catalogue {
     namespace geo {
@@ -12,7 +14,32 @@ namespace transport_catalogue {
             bool operator!=(const Coordinates& other) const;
         };
 
+        inline constexpr double EARTH_RADIUS = 6371000;
+
         double ComputeDistance(Coordinates from, Coordinates to);
 
+        // Точки на единичной сфере, соответствующие координатам, хранятся отдельными массивами по осям.
+        // Синусы и косинусы широты и долготы вычисляются один раз при добавлении точки, поэтому расстояние
+        // по большой окружности сводится к скалярному произведению и одному арккосинусу. Длина каждого отрезка
+        // отличается от ComputeDistance только округлением, не больше чем на 0.05 м
+        class SpherePoints {
+        public:
+            void Reserve(size_t count);
+            void Add(Coordinates coordinates);
+            void Set(std::uint32_t index, Coordinates coordinates);
+
+            // Длина ломаной через точки с номерами из [path_begin, path_end)
+            double ComputePathLength(const std::uint32_t* path_begin, const std::uint32_t* path_end) const;
+
+        private:
+            // скалярные произведения считаются пакетами отдельным циклом без зависимостей между итерациями,
+            // который компилятор может векторизовать, арккосинусы — следующим циклом
+            static constexpr size_t BATCH_SIZE = 64;
+
+            std::vector<double> x_;
+            std::vector<double> y_;
+            std::vector<double> z_;
+        };
+
     } // namespace geo
 } // namespace transpotr_catalogue
\ No newline at end of file
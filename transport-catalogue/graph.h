@@ -2,6 +2,7 @@
 
 #include "ranges.h"
 
+#include <algorithm>
 #include <cstdlib>
 #include <utility>
 #include <vector>
@@ -28,6 +29,9 @@ namespace graph {
         explicit DirectedWeightedGraph(size_t vertex_count);
         explicit DirectedWeightedGraph(std::vector<Edge<Weight>>&& edges, std::vector<IncidenceList>&& incidence_lists);
         EdgeId AddEdge(const Edge<Weight>& edge);
+        void SetEdgeWeight(EdgeId edge_id, Weight weight);
+        // Ребро остаётся в списке рёбер (идентификаторы не сдвигаются), но исключается из списка инцидентности
+        void RemoveEdge(EdgeId edge_id);
 
         size_t GetVertexCount() const;
         size_t GetEdgeCount() const;
@@ -59,6 +63,17 @@ namespace graph {
         return id;
     }
 
+    template <typename Weight>
+    void DirectedWeightedGraph<Weight>::SetEdgeWeight(EdgeId edge_id, Weight weight) {
+        edges_.at(edge_id).weight = weight;
+    }
+
+    template <typename Weight>
+    void DirectedWeightedGraph<Weight>::RemoveEdge(EdgeId edge_id) {
+        auto& incidence_list = incidence_lists_.at(edges_.at(edge_id).from);
+        incidence_list.erase(std::remove(incidence_list.begin(), incidence_list.end(), edge_id), incidence_list.end());
+    }
+
     template <typename Weight>
     size_t DirectedWeightedGraph<Weight>::GetVertexCount() const {
         return incidence_lists_.size();
@@ -75,7 +90,7 @@ namespace graph {
     }
 
     template <typename Weight>
-    typename IncidentEdgesRange
+    IncidentEdgesRange
     DirectedWeightedGraph<Weight>::GetIncidentEdges(VertexId vertex) const {
         return ranges::AsRange(incidence_lists_.at(vertex));
     }
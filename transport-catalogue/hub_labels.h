@@ -0,0 +1,256 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+    // Двухуровневая разметка (2-hop labeling): у каждой вершины есть прямой список меток (хаб, расстояние от вершины до хаба)
+    // и обратный (хаб, расстояние от хаба до вершины). Кратчайшее расстояние from -> to — минимум по общим хабам,
+    // поэтому запрос сводится к слиянию двух отсортированных списков. Метки строятся методом pruned landmark labeling
+    template <typename Weight>
+    class HubLabels {
+    private:
+        using Graph = DirectedWeightedGraph<Weight>;
+
+    public:
+        struct Label {
+            // ранг хаба в порядке обхода, списки меток отсортированы по нему
+            std::uint32_t hub;
+            // первое ребро пути до хаба в прямых метках и последнее ребро пути от хаба в обратных,
+            // не используется в метке самого хаба
+            std::uint32_t edge;
+            Weight weight;
+        };
+
+        struct Labels {
+            std::vector<std::uint32_t> offsets;
+            std::vector<Label> labels;
+        };
+
+        explicit HubLabels(const Graph& graph);
+        HubLabels(const Graph& graph, std::vector<VertexId>&& order, Labels&& forward_labels, Labels&& backward_labels);
+
+        std::optional<typename Router<Weight>::RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+
+        const std::vector<VertexId>& GetOrder() const;
+        const Labels& GetForwardLabels() const;
+        const Labels& GetBackwardLabels() const;
+
+    private:
+        using QueueItem = std::pair<Weight, VertexId>;
+        using Queue = std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>>;
+
+        const Graph& graph_;
+        std::vector<VertexId> order_;
+        Labels forward_labels_;
+        Labels backward_labels_;
+
+        static std::vector<VertexId> ComputeOrder(const Graph& graph, const std::vector<IncidenceList>& incoming_edges) {
+            const size_t vertex_count = graph.GetVertexCount();
+            std::vector<size_t> importance(vertex_count);
+            for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+                const auto outgoing_edges = graph.GetIncidentEdges(vertex);
+                const size_t out_degree = std::distance(outgoing_edges.begin(), outgoing_edges.end());
+                importance[vertex] = (out_degree + 1) * (incoming_edges[vertex].size() + 1);
+            }
+            std::vector<VertexId> order(vertex_count);
+            for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+                order[vertex] = vertex;
+            }
+            std::stable_sort(order.begin(), order.end(), [&importance](VertexId lhs, VertexId rhs) {
+                return importance[lhs] > importance[rhs];
+            });
+            return order;
+        }
+
+        // Поиск от хаба по исходящим (is_forward_search) или входящим рёбрам с отсечением вершин,
+        // расстояние до которых уже покрыто построенными метками
+        static void PrunedSearch(const Graph& graph, const std::vector<IncidenceList>& incoming_edges, std::uint32_t hub_rank,
+                                 VertexId hub, bool is_forward_search, std::vector<std::vector<Label>>& hub_side_labels,
+                                 std::vector<std::vector<Label>>& search_side_labels, std::vector<std::optional<Weight>>& hub_weights,
+                                 std::vector<std::optional<Weight>>& weights, std::vector<EdgeId>& edges) {
+            for (const Label& label : hub_side_labels[hub]) {
+                hub_weights[label.hub] = label.weight;
+            }
+
+            std::vector<VertexId> visited_vertices{hub};
+            Queue queue;
+            weights[hub] = Weight{};
+            edges[hub] = 0;
+            queue.push({Weight{}, hub});
+            while (!queue.empty()) {
+                const auto [weight, vertex] = queue.top();
+                queue.pop();
+                if (*weights[vertex] < weight) {
+                    continue;
+                }
+                bool is_covered = false;
+                for (const Label& label : search_side_labels[vertex]) {
+                    if (hub_weights[label.hub] && *hub_weights[label.hub] + label.weight <= weight) {
+                        is_covered = true;
+                        break;
+                    }
+                }
+                if (is_covered) {
+                    continue;
+                }
+                search_side_labels[vertex].push_back({hub_rank, static_cast<std::uint32_t>(edges[vertex]), weight});
+
+                const auto relax = [&](EdgeId edge_id, VertexId next_vertex) {
+                    const Weight candidate_weight = weight + graph.GetEdge(edge_id).weight;
+                    if (!weights[next_vertex] || candidate_weight < *weights[next_vertex]) {
+                        if (!weights[next_vertex]) {
+                            visited_vertices.push_back(next_vertex);
+                        }
+                        weights[next_vertex] = candidate_weight;
+                        edges[next_vertex] = edge_id;
+                        queue.push({candidate_weight, next_vertex});
+                    }
+                };
+                if (is_forward_search) {
+                    for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
+                        relax(edge_id, graph.GetEdge(edge_id).to);
+                    }
+                } else {
+                    for (const EdgeId edge_id : incoming_edges[vertex]) {
+                        relax(edge_id, graph.GetEdge(edge_id).from);
+                    }
+                }
+            }
+
+            for (const VertexId vertex : visited_vertices) {
+                weights[vertex].reset();
+            }
+            for (const Label& label : hub_side_labels[hub]) {
+                hub_weights[label.hub].reset();
+            }
+        }
+
+        static Labels Flatten(std::vector<std::vector<Label>>&& vertex_labels) {
+            Labels result;
+            result.offsets.reserve(vertex_labels.size() + 1);
+            result.offsets.push_back(0);
+            for (auto& labels : vertex_labels) {
+                result.labels.insert(result.labels.end(), labels.begin(), labels.end());
+                result.offsets.push_back(static_cast<std::uint32_t>(result.labels.size()));
+                std::vector<Label>().swap(labels);
+            }
+            return result;
+        }
+
+        const Label* FindLabel(const Labels& labels, VertexId vertex, std::uint32_t hub_rank) const {
+            const auto begin = labels.labels.begin() + labels.offsets[vertex];
+            const auto end = labels.labels.begin() + labels.offsets[vertex + 1];
+            const auto it = std::lower_bound(begin, end, hub_rank, [](const Label& label, std::uint32_t rank) {
+                return label.hub < rank;
+            });
+            if (it == end || it->hub != hub_rank) {
+                throw std::logic_error("Hub labels are inconsistent");
+            }
+            return &*it;
+        }
+    };
+
+    template <typename Weight>
+    HubLabels<Weight>::HubLabels(const Graph& graph)
+        : graph_(graph) {
+        const size_t vertex_count = graph.GetVertexCount();
+        std::vector<IncidenceList> incoming_edges(vertex_count);
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
+                if (graph.GetEdge(edge_id).weight < Weight{}) {
+                    throw std::domain_error("Edges' weights should be non-negative");
+                }
+                incoming_edges[graph.GetEdge(edge_id).to].push_back(edge_id);
+            }
+        }
+        order_ = ComputeOrder(graph, incoming_edges);
+
+        std::vector<std::vector<Label>> forward_labels(vertex_count), backward_labels(vertex_count);
+        std::vector<std::optional<Weight>> hub_weights(vertex_count), weights(vertex_count);
+        std::vector<EdgeId> edges(vertex_count);
+        for (std::uint32_t hub_rank = 0; hub_rank < vertex_count; ++hub_rank) {
+            const VertexId hub = order_[hub_rank];
+            PrunedSearch(graph, incoming_edges, hub_rank, hub, true, forward_labels, backward_labels, hub_weights, weights, edges);
+            PrunedSearch(graph, incoming_edges, hub_rank, hub, false, backward_labels, forward_labels, hub_weights, weights, edges);
+        }
+
+        forward_labels_ = Flatten(std::move(forward_labels));
+        backward_labels_ = Flatten(std::move(backward_labels));
+    }
+
+    template <typename Weight>
+    HubLabels<Weight>::HubLabels(const Graph& graph, std::vector<VertexId>&& order, Labels&& forward_labels, Labels&& backward_labels)
+        : graph_(graph), order_(std::move(order)), forward_labels_(std::move(forward_labels)), backward_labels_(std::move(backward_labels)) {}
+
+    template <typename Weight>
+    std::optional<typename Router<Weight>::RouteInfo> HubLabels<Weight>::BuildRoute(VertexId from, VertexId to) const {
+        const Label* from_it = forward_labels_.labels.data() + forward_labels_.offsets.at(from);
+        const Label* const from_end = forward_labels_.labels.data() + forward_labels_.offsets.at(from + 1);
+        const Label* to_it = backward_labels_.labels.data() + backward_labels_.offsets.at(to);
+        const Label* const to_end = backward_labels_.labels.data() + backward_labels_.offsets.at(to + 1);
+
+        std::optional<std::pair<const Label*, const Label*>> best_labels;
+        while (from_it != from_end && to_it != to_end) {
+            if (from_it->hub < to_it->hub) {
+                ++from_it;
+            } else if (to_it->hub < from_it->hub) {
+                ++to_it;
+            } else {
+                if (!best_labels || from_it->weight + to_it->weight < best_labels->first->weight + best_labels->second->weight) {
+                    best_labels = std::make_pair(from_it, to_it);
+                }
+                ++from_it;
+                ++to_it;
+            }
+        }
+        if (!best_labels) {
+            return std::nullopt;
+        }
+
+        const std::uint32_t hub_rank = best_labels->first->hub;
+        const VertexId hub = order_[hub_rank];
+        std::vector<EdgeId> edges;
+        for (VertexId vertex = from; vertex != hub; ) {
+            const EdgeId edge_id = FindLabel(forward_labels_, vertex, hub_rank)->edge;
+            edges.push_back(edge_id);
+            vertex = graph_.GetEdge(edge_id).to;
+        }
+        const size_t hub_position = edges.size();
+        for (VertexId vertex = to; vertex != hub; ) {
+            const EdgeId edge_id = FindLabel(backward_labels_, vertex, hub_rank)->edge;
+            edges.push_back(edge_id);
+            vertex = graph_.GetEdge(edge_id).from;
+        }
+        std::reverse(edges.begin() + hub_position, edges.end());
+
+        return typename Router<Weight>::RouteInfo{best_labels->first->weight + best_labels->second->weight, std::move(edges)};
+    }
+
+    template <typename Weight>
+    const std::vector<VertexId>& HubLabels<Weight>::GetOrder() const {
+        return order_;
+    }
+
+    template <typename Weight>
+    const typename HubLabels<Weight>::Labels& HubLabels<Weight>::GetForwardLabels() const {
+        return forward_labels_;
+    }
+
+    template <typename Weight>
+    const typename HubLabels<Weight>::Labels& HubLabels<Weight>::GetBackwardLabels() const {
+        return backward_labels_;
+    }
+
+}  // namespace graph
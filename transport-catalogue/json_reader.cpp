@@ -2,8 +2,14 @@
 #include "serialization.h"
 
 #include <algorithm>
+#include <cmath>
+#include <cstdio>
 #include <fstream>
+#include <limits>
+#include <map>
+#include <memory>
 #include <sstream>
+#include <stdexcept>
 #include <string>
 #include <string_view>
 #include <tuple>
@@ -14,134 +20,394 @@ using namespace std;
 namespace transport_catalogue {
     namespace json_reader {
 
-        pair<string, geo::Coordinates> GetStopFromRequest(const json::Dict& stop_request) {
-            return {stop_request.at("name"s).AsString(), {stop_request.at("latitude"s).AsDouble(), stop_request.at("longitude"s).AsDouble()}};
+        geo::Coordinates GetStopCoordinatesFromRequest(const json::Dict& stop_request) {
+            return {stop_request.at("latitude"s).AsDouble(), stop_request.at("longitude"s).AsDouble()};
         }
 
-        tuple<string, vector<string>, bool> GetBusFromRequest(const json::Dict& bus_request) {
-            string bus_name = bus_request.at("name"s).AsString();
-            vector<string> stops;
-            bool is_roundtrip = bus_request.at("is_roundtrip"s).AsBool();
-            for (const auto& stop : bus_request.at("stops"s).AsArray()) {
-                stops.push_back(stop.AsString());
+        vector<domain::StopId> GetBusStopsFromRequest(const CatalogueBuilder& builder, const json::Dict& bus_request) {
+            const json::Array& stop_names = bus_request.at("stops"s).AsArray();
+            vector<domain::StopId> stops;
+            stops.reserve(stop_names.size());
+            for (const auto& stop : stop_names) {
+                stops.push_back(builder.GetStop(stop.AsString()));
             }
-            
-            return tie(bus_name, stops, is_roundtrip);
+            return stops;
         }
 
-        void SetDistanceToStopsFromRequest (TransportCatalogue& catalogue, const json::Dict& stop_request) {
-            string stop_from = stop_request.at("name"s).AsString();
+        void SetDistanceToStopsFromRequest(CatalogueBuilder& builder, domain::StopId stop_from, const json::Dict& stop_request) {
             for (const auto& [stop_to, distance] : stop_request.at("road_distances"s).AsDict()) {
-                catalogue.SetDistance(catalogue.GetStop(stop_from), catalogue.GetStop(stop_to), distance.AsInt());
+                builder.SetDistance(stop_from, builder.GetStop(stop_to), distance.AsInt());
             }
         }
 
-        void BaseRequestProcess (TransportCatalogue& catalogue, const json::Array& base_request) {
+        // Названия передаются в справочник как string_view на разобранный JSON и копируются только в его хранилище.
+        // С previous справочник заполняется его данными, а запросы применяются к ним как изменения:
+        // остановки и автобусы с известными названиями заменяются, заданные расстояния переопределяются
+        void BaseRequestProcess (TransportCatalogue& catalogue, const json::Array& base_request, const TransportCatalogue* previous = nullptr) {
             vector<const json::Dict*> buses_buffer, stops_buffer;
+            size_t distances_count = 0;
             for (const auto& request : base_request) {
-                if (request.AsDict().at("type"s).AsString() == "Stop"s) {
-                    auto [stop_name, coordinates] = GetStopFromRequest(request.AsDict());
-                    catalogue.AddStop(stop_name, move(coordinates));
-                    if (request.AsDict().count("road_distances"s)) {
-                        stops_buffer.push_back(&request.AsDict());
+                const string& type = request.AsDict().at("type"s).AsString();
+                if (type == "Stop"s) {
+                    stops_buffer.push_back(&request.AsDict());
+                    if (const auto it = request.AsDict().find("road_distances"s); it != request.AsDict().end()) {
+                        distances_count += it->second.AsDict().size();
                     }
-                } else if (request.AsDict().at("type"s).AsString() == "Bus"s) {
+                } else if (type == "Bus"s) {
                     buses_buffer.push_back(&request.AsDict());
-                } else {
-                    continue;
                 }
             }
 
-            for (const auto& request : buses_buffer) {
-                auto bus = GetBusFromRequest(*request);
-                string bus_name = get<string>(bus);
-                auto stops = get<vector<string>>(bus);
-                bool is_roundtrip = get<bool>(bus);
-                catalogue.AddBus(bus_name, stops, is_roundtrip);
+            CatalogueBuilder builder(catalogue, stops_buffer.size() + (previous ? previous->GetStopsCount() : 0), distances_count);
+            if (previous) {
+                builder.AddCatalogue(*previous);
+            }
+            vector<pair<domain::StopId, const json::Dict*>> stops_with_distances;
+            for (const json::Dict* request : stops_buffer) {
+                const string& stop_name = request->at("name"s).AsString();
+                const geo::Coordinates coordinates = GetStopCoordinatesFromRequest(*request);
+                const domain::StopId stop = previous ? builder.SetStop(stop_name, coordinates) : builder.AddStop(stop_name, coordinates);
+                if (request->count("road_distances"s)) {
+                    stops_with_distances.emplace_back(stop, request);
+                }
+            }
+
+            for (const json::Dict* request : buses_buffer) {
+                builder.AddBus(request->at("name"s).AsString(), GetBusStopsFromRequest(builder, *request), request->at("is_roundtrip"s).AsBool());
             }
 
-            for (const auto& request : stops_buffer) {
-                SetDistanceToStopsFromRequest(catalogue, *request);
+            for (const auto& [stop, request] : stops_with_distances) {
+                SetDistanceToStopsFromRequest(builder, stop, *request);
             }
+            builder.Build();
+            // после загрузки справочник только читается
+            catalogue.Freeze();
+        }
+
+        vector<string_view> GetViaStopNames(const StatRequest& request) {
+            return {request.via.begin(), request.via.end()};
+        }
+
+        // Остановки маршрута по порядку: начальная, промежуточные и конечная
+        vector<string_view> GetRouteStopNames(const StatRequest& request) {
+            vector<string_view> stop_names{request.from};
+            stop_names.insert(stop_names.end(), request.via.begin(), request.via.end());
+            stop_names.push_back(request.to);
+            return stop_names;
+        }
+
+        bool HasSearchLimits(const StatRequest& request) {
+            return request.search_settle_limit || request.search_time_limit;
+        }
+
+        // Общим поиском из начальной остановки строятся только маршруты без собственных ограничений и времени отправления
+        bool IsGroupable(const StatRequest& request) {
+            return request.type == RequestType::ROUTE && !HasSearchLimits(request) && !request.departure_time;
         }
 
-        json::Document StatRequestProcess (TransportCatalogue& catalogue, const vector<StatRequest>& stat_request,  const request_handler::RequestHandler& handler,  const transport_router::TransportRouter& router) {
-            json::Array result;
-            for (const auto& request : stat_request) {
-                json::Builder builder;
-                builder.StartDict().Key("request_id"s).Value(request.id);
-                switch (request.type) {
-                    case RequestType::BUS: {
-                        if (const auto& bus = catalogue.GetBus(request.name)) {
-                            domain::RouteInfo route_info = catalogue.GetRouteInfo(bus);
-                            builder.Key("curvature"s).Value(route_info.route_curvature)
+        transport_router::SearchLimits GetSearchLimits(const StatRequest& request, const transport_router::TransportRouter& router) {
+            transport_router::SearchLimits limits = router.GetRouterSettings().search_limits;
+            limits.settle_limit = request.search_settle_limit.value_or(limits.settle_limit);
+            limits.time_limit = request.search_time_limit.value_or(limits.time_limit);
+            return limits;
+        }
+
+        // Отрезки маршрутов всех запросов с общей начальной остановкой строятся одним поиском,
+        // ответы раскладываются по номерам запросов и отрезков. Поиски из разных остановок выполняются в pool параллельно.
+        // Запросы с собственными ограничениями поиска и временем отправления, а также запросы, общий поиск для которых исчерпал ограничения, в ответ не попадают и обрабатываются по отдельности
+        map<size_t, optional<transport_router::TransportRouter::RouteItems>> GetRoutesGroupedByOrigin(const vector<StatRequest>& stat_request, const transport_router::TransportRouter& router, WorkStealingPool& pool) {
+            struct Leg {
+                size_t request;
+                size_t leg;
+                string_view stop_to;
+            };
+            map<string_view, vector<Leg>> legs_by_origin;
+            vector<vector<optional<transport_router::TransportRouter::RouteItems>>> request_legs(stat_request.size());
+            for (size_t i = 0; i < stat_request.size(); ++i) {
+                if (IsGroupable(stat_request[i])) {
+                    const auto stop_names = GetRouteStopNames(stat_request[i]);
+                    request_legs[i].resize(stop_names.size() - 1);
+                    for (size_t j = 0; j + 1 < stop_names.size(); ++j) {
+                        legs_by_origin[stop_names[j]].push_back({i, j, stop_names[j + 1]});
+                    }
+                }
+            }
+
+            vector<const pair<const string_view, vector<Leg>>*> origins;
+            origins.reserve(legs_by_origin.size());
+            for (const auto& origin : legs_by_origin) {
+                origins.push_back(&origin);
+            }
+            // vector<bool> хранит флаги в общих словах, поэтому параллельно записываются байты
+            vector<char> is_interrupted(stat_request.size());
+            pool.ParallelFor(origins.size(), [&](size_t origin) {
+                const auto& [stop_from, legs] = *origins[origin];
+                vector<string_view> stops_to;
+                stops_to.reserve(legs.size());
+                for (const Leg& leg : legs) {
+                    stops_to.push_back(leg.stop_to);
+                }
+                try {
+                    auto routes_from_stop = router.GetRoutesFromStop(stop_from, stops_to);
+                    for (size_t i = 0; i < legs.size(); ++i) {
+                        request_legs[legs[i].request][legs[i].leg] = move(routes_from_stop[i]);
+                    }
+                } catch (const graph::SearchBudgetExceeded&) {
+                    for (const Leg& leg : legs) {
+                        is_interrupted[leg.request] = true;
+                    }
+                }
+            });
+
+            map<size_t, optional<transport_router::TransportRouter::RouteItems>> routes;
+            for (size_t i = 0; i < stat_request.size(); ++i) {
+                if (IsGroupable(stat_request[i]) && !is_interrupted[i]) {
+                    routes[i] = transport_router::TransportRouter::JoinRoutes(move(request_legs[i]));
+                }
+            }
+            return routes;
+        }
+
+        void AddRouteToAnswer(json::Builder& builder, const optional<transport_router::TransportRouter::RouteItems>& items) {
+            if (items) {
+                builder.Key("total_time").Value(items.value().total_time)
+                .Key("items").StartArray();
+                for (const auto& item : items.value().items) {
+                    if (item.type == "Wait"s) {
+                        builder.StartDict()
+                        .Key("type"s).Value(item.type)
+                        .Key("stop_name"s).Value(item.name)
+                        .Key("time"s).Value(item.time)
+                        .EndDict();
+                    } else {
+                        builder.StartDict()
+                        .Key("type"s).Value(item.type)
+                        .Key("bus"s).Value(item.name)
+                        .Key("span_count"s).Value(item.span_count)
+                        .Key("time"s).Value(item.time)
+                        .EndDict();
+                    }
+                }
+                builder.EndArray();
+            } else {
+                builder.Key("error_message"s).Value("not found"s);
+            }
+        }
+
+        void AddNamesToAnswer(json::Builder& builder, const string& key, const vector<string>& names) {
+            builder.Key(key).StartArray();
+            for (const string& name : names) {
+                builder.Value(name);
+            }
+            builder.EndArray();
+        }
+
+        // Суммы по всем автобусам могут не уместиться в int, тогда они выводятся как double
+        json::Node::Value GetTotalValue(int64_t total) {
+            if (total >= numeric_limits<int>::min() && total <= numeric_limits<int>::max()) {
+                return static_cast<int>(total);
+            }
+            return static_cast<double>(total);
+        }
+
+        // У автобуса нулевой геодлины извилистость не определена, в отчёт она выводится как null
+        json::Node::Value GetCurvatureValue(double curvature) {
+            if (!isfinite(curvature)) {
+                return nullptr;
+            }
+            return curvature;
+        }
+
+        // Ответ на i-й запрос. Маршруты сгруппированных запросов забираются из grouped_routes
+        json::Node ProcessStatRequest(const TransportCatalogue& catalogue, const vector<StatRequest>& stat_request, size_t i, const request_handler::RequestHandler& handler,
+                                      const transport_router::TransportRouter& router, map<size_t, optional<transport_router::TransportRouter::RouteItems>>& grouped_routes) {
+            const auto& request = stat_request[i];
+            json::Builder builder;
+            builder.StartDict().Key("request_id"s).Value(request.id);
+            switch (request.type) {
+                case RequestType::ANALYTICS: {
+                    const domain::BusStatsReport report = catalogue.GetBusStatsReport(request.analytics);
+                    builder.Key("bus_count"s).Value(static_cast<int>(report.bus_count))
+                    .Key("total_stop_count"s).Value(GetTotalValue(report.total_stops_number))
+                    .Key("total_unique_stop_count"s).Value(GetTotalValue(report.unique_stops_number))
+                    .Key("total_route_length"s).Value(GetTotalValue(report.route_length));
+                    if (request.analytics.sort_by) {
+                        builder.Key("buses"s).StartArray();
+                        for (const domain::BusIndex bus : report.buses) {
+                            const domain::Bus& bus_data = catalogue.GetBusByIndex(bus);
+                            const domain::RouteInfo route_info = catalogue.GetRouteInfo(&bus_data);
+                            builder.StartDict()
+                            .Key("name"s).Value(string(bus_data.name))
+                            .Key("curvature"s).Value(GetCurvatureValue(route_info.route_curvature))
                             .Key("route_length"s).Value(route_info.route_length)
                             .Key("stop_count"s).Value(route_info.total_stops_number)
-                            .Key("unique_stop_count"s).Value(route_info.unique_stops_number);
-                        } else {
-                            builder.Key("error_message"s).Value("not found"s);
+                            .Key("unique_stop_count"s).Value(route_info.unique_stops_number)
+                            .EndDict();
                         }
-                        break;
-                    } case RequestType::MAP: {
-                        ostringstream output;
-                        handler.RenderMap().Render(output);
-                        builder.Key("map"s).Value(output.str());
-                        break;
-                    } case RequestType::ROUTE: {
-                        auto items = router.GetRouteByStops(request.from, request.to);
-                        if (items) {
-                            builder.Key("total_time").Value(items.value().total_time)
-                            .Key("items").StartArray();
-                            for (const auto& item : items.value().items) {
-                                if (item.type == "Wait"s) {
-                                    builder.StartDict()
-                                    .Key("type"s).Value(item.type)
-                                    .Key("stop_name"s).Value(item.name)
-                                    .Key("time"s).Value(item.time)
-                                    .EndDict();
-                                } else {
-                                    builder.StartDict()
-                                    .Key("type"s).Value(item.type)
-                                    .Key("bus"s).Value(item.name)
-                                    .Key("span_count"s).Value(item.span_count)
-                                    .Key("time"s).Value(item.time)
-                                    .EndDict();
-                                }
-                            }
-                            builder.EndArray();
+                        builder.EndArray();
+                    }
+                    break;
+                } case RequestType::BUS: {
+                    if (const auto& bus = catalogue.GetBus(request.name)) {
+                        domain::RouteInfo route_info = catalogue.GetRouteInfo(bus);
+                        builder.Key("curvature"s).Value(route_info.route_curvature)
+                        .Key("route_length"s).Value(route_info.route_length)
+                        .Key("stop_count"s).Value(route_info.total_stops_number)
+                        .Key("unique_stop_count"s).Value(route_info.unique_stops_number);
+                    } else {
+                        builder.Key("error_message"s).Value("not found"s);
+                    }
+                    break;
+                } case RequestType::DIRECT_BUSES: {
+                    const auto from = catalogue.GetStop(request.from);
+                    const auto to = catalogue.GetStop(request.to);
+                    if (from && to) {
+                        builder.Key("buses"s).StartArray();
+                        for (const domain::BusIndex bus : catalogue.GetDirectBuses(*from, *to)) {
+                            builder.Value(string(catalogue.GetBusByIndex(bus).name));
+                        }
+                        builder.EndArray();
+                    } else {
+                        builder.Key("error_message"s).Value("not found"s);
+                    }
+                    break;
+                } case RequestType::MAP: {
+                    ostringstream output;
+                    handler.RenderMap().Render(output);
+                    builder.Key("map"s).Value(output.str());
+                    break;
+                } case RequestType::ROUTE: {
+                    optional<transport_router::TransportRouter::RouteItems> items;
+                    try {
+                        if (const auto it = grouped_routes.find(i); it != grouped_routes.end()) {
+                            items = move(it->second);
+                        } else if (request.departure_time) {
+                            items = router.GetRouteAtTime(request.from, GetViaStopNames(request), request.to, *request.departure_time, GetSearchLimits(request, router));
+                        } else if (request.via.empty()) {
+                            items = router.GetRouteByStops(request.from, request.to, GetSearchLimits(request, router));
                         } else {
-                            builder.Key("error_message"s).Value("not found"s);
+                            items = router.GetRouteViaStops(request.from, GetViaStopNames(request), request.to, GetSearchLimits(request, router));
                         }
+                    } catch (const graph::SearchBudgetExceeded&) {
+                        builder.Key("error_message"s).Value("timeout"s);
                         break;
-                    } case RequestType::STOP: {
-                        if (const auto& stop = catalogue.GetStop(request.name)) {                            
-                            auto buses_for_stop = catalogue.GetBusesForStop(stop->name);
-                            //json::Array buses;
-                            builder.Key("buses"s).StartArray();
-                            if (buses_for_stop) {
-                                vector<string> buses_names;
-                                for (const auto& bus : *buses_for_stop) {
-                                    buses_names.push_back(bus->name);
-                                }
-                                sort(buses_names.begin(), buses_names.end());
-                                buses_names.erase(unique(buses_names.begin(), buses_names.end()), buses_names.end());
-                                
-                                for (const auto& bus : buses_names) {
-                                    builder.Value(bus);
-                                }
-                            }
-                            builder.EndArray();
-                        } else {
-                            builder.Key("error_message"s).Value("not found"s);
+                    }
+                    AddRouteToAnswer(builder, items);
+                    break;
+                } case RequestType::STOP: {
+                    if (const auto& stop = catalogue.GetStop(request.name)) {
+                        // список уже упорядочен по названиям и не содержит повторов
+                        builder.Key("buses"s).StartArray();
+                        for (const domain::BusIndex bus : catalogue.GetBusesForStop(*stop)) {
+                            builder.Value(string(catalogue.GetBusByIndex(bus).name));
                         }
+                        builder.EndArray();
+                    } else {
+                        builder.Key("error_message"s).Value("not found"s);
+                    }
+                    break;
+                } case RequestType::STOP_SEARCH: {
+                    const vector<domain::StopId> stops = request.search_mode == StopSearchMode::FUZZY
+                        ? catalogue.FindSimilarStops(request.query, request.max_distance, request.limit)
+                        : catalogue.FindStopsByPrefix(request.query, request.limit);
+                    builder.Key("stops"s).StartArray();
+                    for (const domain::StopId stop : stops) {
+                        builder.Value(string(catalogue.GetStopName(stop)));
+                    }
+                    builder.EndArray();
+                    break;
+                } case RequestType::WTF: {
+                    break;
+                }
+            }
+            builder.EndDict();
+            return builder.Build();
+        }
+
+        // Запросы только читают справочник и маршрутизатор, поэтому выполняются в pool параллельно. Ответ каждого
+        // записывается в свою ячейку, и массив ответов собирается в порядке запросов
+        json::Document StatRequestProcess (const TransportCatalogue& catalogue, const vector<StatRequest>& stat_request,  const request_handler::RequestHandler& handler,  const transport_router::TransportRouter& router, WorkStealingPool& pool) {
+            map<size_t, optional<transport_router::TransportRouter::RouteItems>> grouped_routes;
+            if (router.GetRouterSettings().routing_mode == transport_router::RoutingMode::ON_DEMAND) {
+                grouped_routes = GetRoutesGroupedByOrigin(stat_request, router, pool);
+            }
+            // ячейки заполняются каждая своим запросом, а сам словарь grouped_routes не изменяется
+            json::Array result(stat_request.size());
+            pool.ParallelFor(stat_request.size(), [&](size_t i) {
+                result[i] = ProcessStatRequest(catalogue, stat_request, i, handler, router, grouped_routes);
+            });
+            return json::Document(result);
+        }
+
+        // Ответ по базе, разделённой на регионы. Карта и отчёты по всем автобусам потребовали бы прочитать все базы регионов,
+        // а маршрут со временем отправления — профили автобусов всех регионов, поэтому такие запросы не поддерживаются
+        json::Node ProcessRegionalStatRequest(const regional_base::RegionalCatalogue& catalogue, const StatRequest& request) {
+            json::Builder builder;
+            builder.StartDict().Key("request_id"s).Value(request.id);
+            switch (request.type) {
+                case RequestType::BUS: {
+                    if (const auto route_info = catalogue.GetRouteInfo(request.name)) {
+                        builder.Key("curvature"s).Value(route_info->route_curvature)
+                        .Key("route_length"s).Value(route_info->route_length)
+                        .Key("stop_count"s).Value(route_info->total_stops_number)
+                        .Key("unique_stop_count"s).Value(route_info->unique_stops_number);
+                    } else {
+                        builder.Key("error_message"s).Value("not found"s);
+                    }
+                    break;
+                } case RequestType::DIRECT_BUSES: {
+                    if (const auto buses = catalogue.GetDirectBuses(request.from, request.to)) {
+                        AddNamesToAnswer(builder, "buses"s, *buses);
+                    } else {
+                        builder.Key("error_message"s).Value("not found"s);
+                    }
+                    break;
+                } case RequestType::ROUTE: {
+                    if (request.departure_time) {
+                        builder.Key("error_message"s).Value("not supported"s);
                         break;
-                    } case RequestType::WTF: {
+                    }
+                    transport_router::SearchLimits limits = catalogue.GetSearchLimits();
+                    limits.settle_limit = request.search_settle_limit.value_or(limits.settle_limit);
+                    limits.time_limit = request.search_time_limit.value_or(limits.time_limit);
+                    optional<transport_router::TransportRouter::RouteItems> items;
+                    try {
+                        items = catalogue.GetRouteViaStops(request.from, GetViaStopNames(request), request.to, limits);
+                    } catch (const graph::SearchBudgetExceeded&) {
+                        builder.Key("error_message"s).Value("timeout"s);
                         break;
                     }
+                    AddRouteToAnswer(builder, items);
+                    break;
+                } case RequestType::STOP: {
+                    if (const auto buses = catalogue.GetBusesForStop(request.name)) {
+                        AddNamesToAnswer(builder, "buses"s, *buses);
+                    } else {
+                        builder.Key("error_message"s).Value("not found"s);
+                    }
+                    break;
+                } case RequestType::STOP_SEARCH: {
+                    AddNamesToAnswer(builder, "stops"s, request.search_mode == StopSearchMode::FUZZY
+                        ? catalogue.FindSimilarStops(request.query, request.max_distance, request.limit)
+                        : catalogue.FindStopsByPrefix(request.query, request.limit));
+                    break;
+                } case RequestType::ANALYTICS:
+                  case RequestType::MAP: {
+                    builder.Key("error_message"s).Value("not supported"s);
+                    break;
+                } case RequestType::WTF: {
+                    break;
                 }
-                builder.EndDict();
-                result.push_back(builder.Build());          
             }
+            builder.EndDict();
+            return builder.Build();
+        }
+
+        json::Document RegionalStatRequestProcess(const regional_base::RegionalCatalogue& catalogue, const vector<StatRequest>& stat_request, WorkStealingPool& pool) {
+            json::Array result(stat_request.size());
+            pool.ParallelFor(stat_request.size(), [&](size_t i) {
+                result[i] = ProcessRegionalStatRequest(catalogue, stat_request[i]);
+            });
             return json::Document(result);
         }
 
@@ -188,20 +454,171 @@ namespace transport_catalogue {
             renderer.SetSettings(move(settings));
         }
 
+        transport_router::RoutingMode GetRoutingMode(string_view routing_mode) {
+            if (routing_mode == "table"sv) {
+                return transport_router::RoutingMode::TABLE;
+            } else if (routing_mode == "hub_labels"sv) {
+                return transport_router::RoutingMode::HUB_LABELS;
+            } else if (routing_mode == "on_demand"sv) {
+                return transport_router::RoutingMode::ON_DEMAND;
+            } else if (routing_mode == "overlay"sv) {
+                return transport_router::RoutingMode::OVERLAY;
+            } else if (routing_mode == "paged_table"sv) {
+                return transport_router::RoutingMode::PAGED_TABLE;
+            }
+            throw invalid_argument("Unknown routing mode "s + string(routing_mode));
+        }
+
+        StopSearchMode GetStopSearchMode(string_view search_mode) {
+            if (search_mode == "prefix"sv) {
+                return StopSearchMode::PREFIX;
+            } else if (search_mode == "fuzzy"sv) {
+                return StopSearchMode::FUZZY;
+            }
+            throw invalid_argument("Unknown stop search mode "s + string(search_mode));
+        }
+
+        domain::BusStatField GetBusStatField(string_view field) {
+            if (field == "stop_count"sv) {
+                return domain::BusStatField::STOP_COUNT;
+            } else if (field == "unique_stop_count"sv) {
+                return domain::BusStatField::UNIQUE_STOP_COUNT;
+            } else if (field == "route_length"sv) {
+                return domain::BusStatField::ROUTE_LENGTH;
+            } else if (field == "curvature"sv) {
+                return domain::BusStatField::CURVATURE;
+            }
+            throw invalid_argument("Unknown bus statistics field "s + string(field));
+        }
+
+        domain::BusStatsQuery GetBusStatsQueryFromRequest(const json::Dict& request) {
+            domain::BusStatsQuery query;
+            if (request.count("filters"s)) {
+                for (const auto& filter_node : request.at("filters"s).AsArray()) {
+                    const json::Dict& filter_dict = filter_node.AsDict();
+                    domain::BusStatFilter filter{GetBusStatField(filter_dict.at("field"s).AsString())};
+                    if (filter_dict.count("min"s)) {
+                        filter.min = filter_dict.at("min"s).AsDouble();
+                    }
+                    if (filter_dict.count("max"s)) {
+                        filter.max = filter_dict.at("max"s).AsDouble();
+                    }
+                    query.filters.push_back(filter);
+                }
+            }
+            if (request.count("sort_by"s)) {
+                query.sort_by = GetBusStatField(request.at("sort_by"s).AsString());
+            }
+            if (request.count("order"s)) {
+                const string& order = request.at("order"s).AsString();
+                if (order != "asc"s && order != "desc"s) {
+                    throw invalid_argument("Unknown sort order "s + order);
+                }
+                query.is_ascending = order == "asc"s;
+            }
+            if (request.count("limit"s)) {
+                const int limit = request.at("limit"s).AsInt();
+                if (limit < 0) {
+                    throw invalid_argument("Analytics limit should not be negative"s);
+                }
+                query.limit = static_cast<size_t>(limit);
+            }
+            return query;
+        }
+
         void SetRouterSettings(transport_router::RouterSettings& settings, const json::Dict& route_request) {
             settings.bus_wait_time = route_request.at("bus_wait_time"s).AsInt();
             settings.bus_velocity = route_request.at("bus_velocity"s).AsDouble();
+            if (route_request.count("routing_mode"s)) {
+                settings.routing_mode = GetRoutingMode(route_request.at("routing_mode"s).AsString());
+            }
+            if (route_request.count("landmarks_count"s)) {
+                settings.landmarks_count = route_request.at("landmarks_count"s).AsInt();
+            }
+            if (route_request.count("overlay_cells_count"s)) {
+                settings.overlay_cells_count = route_request.at("overlay_cells_count"s).AsInt();
+            }
+            if (route_request.count("table_file"s)) {
+                settings.table_file_name = route_request.at("table_file"s).AsString();
+            }
+            if (route_request.count("table_memory_limit"s)) {
+                settings.table_memory_limit = route_request.at("table_memory_limit"s).AsInt();
+            }
+            if (route_request.count("search_settle_limit"s)) {
+                settings.search_limits.settle_limit = route_request.at("search_settle_limit"s).AsInt();
+            }
+            if (route_request.count("search_time_limit"s)) {
+                settings.search_limits.time_limit = route_request.at("search_time_limit"s).AsInt();
+            }
+            if (route_request.count("bus_profiles"s)) {
+                const auto get_function = [](const json::Dict& profile, const string& key) {
+                    if (!profile.count(key)) {
+                        return graph::PiecewiseLinearFunction{};
+                    }
+                    vector<pair<double, double>> points;
+                    for (const auto& point : profile.at(key).AsArray()) {
+                        points.push_back({point.AsArray().at(0).AsDouble(), point.AsArray().at(1).AsDouble()});
+                    }
+                    return graph::PiecewiseLinearFunction(move(points), transport_router::MINUTES_PER_DAY);
+                };
+                // Скорость положительна, интервал неотрицателен и убывает не быстрее 2 минут за минуту: ожидание — половина
+                // интервала, поэтому пришедший на остановку позже не уезжает раньше. Время в пути рассчитывается по скорости
+                // в каждый момент пути, и с любой положительной скоростью выехавший позже не приезжает раньше
+                const auto check_profile = [](const string& bus_name, const transport_router::BusProfile& profile) {
+                    for (const auto& [minute, velocity] : profile.velocity.GetPoints()) {
+                        if (velocity <= 0) {
+                            throw invalid_argument("Velocity of bus "s + bus_name + " should be positive"s);
+                        }
+                    }
+                    const auto headway = profile.headway.GetPoints();
+                    for (size_t i = 0; i < headway.size(); ++i) {
+                        if (headway[i].second < 0) {
+                            throw invalid_argument("Headway of bus "s + bus_name + " should not be negative"s);
+                        }
+                        if (headway.size() == 1) {
+                            continue;
+                        }
+                        const size_t next = (i + 1) % headway.size();
+                        const double length = next > i ? headway[next].first - headway[i].first : headway[next].first + transport_router::MINUTES_PER_DAY - headway[i].first;
+                        if (headway[next].second - headway[i].second < -2 * length) {
+                            throw invalid_argument("Headway of bus "s + bus_name + " should not decrease faster than 2 minutes per minute"s);
+                        }
+                    }
+                };
+                for (const auto& profile : route_request.at("bus_profiles"s).AsArray()) {
+                    const auto& profile_dict = profile.AsDict();
+                    const string& bus_name = profile_dict.at("bus"s).AsString();
+                    transport_router::BusProfile bus_profile{get_function(profile_dict, "headway"s), get_function(profile_dict, "velocity"s)};
+                    check_profile(bus_name, bus_profile);
+                    settings.bus_profiles[bus_name] = move(bus_profile);
+                }
+            }
+        }
+
+        // Количество регионов, на которые делится база, 0 — база не делится
+        size_t GetRegionsCount(const json::Dict& serialization_settings) {
+            if (!serialization_settings.count("regions_count"s)) {
+                return 0;
+            }
+            const int regions_count = serialization_settings.at("regions_count"s).AsInt();
+            if (regions_count < 0) {
+                throw invalid_argument("Regions count should not be negative"s);
+            }
+            return static_cast<size_t>(regions_count);
         }
 
         void JsonReader::MakeBase(istream& input, TransportCatalogue& catalogue, map_renderer::MapRenderer &renderer, transport_router::RouterSettings& router_settings) {
             json::Document request = json::Load(input);
             
             serialization::Serializator serializator;
+            string file_name;
+            size_t regions_count = 0;
 
             for (const auto& [request_type, request_body] : request.GetRoot().AsDict()) {
                 if (request_type == "serialization_settings" && !request_body.AsDict().empty()) {
-                    string file_name = request_body.AsDict().at("file").AsString();
-                    serializator.SetSettings(move(file_name));
+                    file_name = request_body.AsDict().at("file").AsString();
+                    regions_count = GetRegionsCount(request_body.AsDict());
+                    serializator.SetSettings(string(file_name));
                 } else if (request_type == "base_requests"s && !request_body.AsArray().empty()) {
                     BaseRequestProcess(catalogue, request_body.AsArray());
                 } else if (request_type == "render_settings"s && !request_body.AsDict().empty()) {
@@ -211,6 +628,12 @@ namespace transport_catalogue {
                 }
             }
 
+            // маршрутизатор всей базы не строится, у каждого региона он свой
+            if (regions_count > 0) {
+                regional_base::MakeRegionalBase(file_name, regions_count, catalogue, renderer, router_settings);
+                return;
+            }
+
             transport_router::TransportRouter router(catalogue, router_settings);
             
             serializator.SerializeData(catalogue, renderer, router);
@@ -227,6 +650,39 @@ namespace transport_catalogue {
                 } else if (stat_request.type == RequestType::ROUTE) {
                     stat_request.from = query.AsDict().at("from").AsString();
                     stat_request.to = query.AsDict().at("to").AsString();
+                    if (query.AsDict().count("via")) {
+                        for (const auto& stop : query.AsDict().at("via").AsArray()) {
+                            stat_request.via.push_back(stop.AsString());
+                        }
+                    }
+                    if (query.AsDict().count("search_settle_limit")) {
+                        stat_request.search_settle_limit = query.AsDict().at("search_settle_limit").AsInt();
+                    }
+                    if (query.AsDict().count("search_time_limit")) {
+                        stat_request.search_time_limit = query.AsDict().at("search_time_limit").AsInt();
+                    }
+                    if (query.AsDict().count("departure_time")) {
+                        stat_request.departure_time = query.AsDict().at("departure_time").AsDouble();
+                    }
+                } else if (stat_request.type == RequestType::ANALYTICS) {
+                    stat_request.analytics = GetBusStatsQueryFromRequest(query.AsDict());
+                } else if (stat_request.type == RequestType::DIRECT_BUSES) {
+                    stat_request.from = query.AsDict().at("from").AsString();
+                    stat_request.to = query.AsDict().at("to").AsString();
+                } else if (stat_request.type == RequestType::STOP_SEARCH) {
+                    stat_request.query = query.AsDict().at("query").AsString();
+                    if (query.AsDict().count("mode")) {
+                        stat_request.search_mode = GetStopSearchMode(query.AsDict().at("mode").AsString());
+                    }
+                    if (query.AsDict().count("max_distance")) {
+                        stat_request.max_distance = query.AsDict().at("max_distance").AsInt();
+                    }
+                    if (query.AsDict().count("limit")) {
+                        stat_request.limit = query.AsDict().at("limit").AsInt();
+                    }
+                    if (stat_request.max_distance < 0 || stat_request.limit < 0) {
+                        throw invalid_argument("Stop search limits should not be negative"s);
+                    }
                 }
             }
             
@@ -238,42 +694,205 @@ namespace transport_catalogue {
             map_renderer::RenderSettings render_settings;
 
             for (const auto& [request_type, request_body] : request.GetRoot().AsDict()) {
-                if (request_type == "serialization_settings" && !request_body.AsDict().empty()) {
+                if (request_type == "processing_settings"s && !request_body.AsDict().empty()) {
+                    SetProcessingSettings(request_body.AsDict());
+                } else if (request_type == "serialization_settings" && !request_body.AsDict().empty()) {
                     string file_name = request_body.AsDict().at("file").AsString();
+                    if (GetRegionsCount(request_body.AsDict()) > 0) {
+                        // базы регионов читаются по мере надобности при ответах
+                        regional_catalogue_ = make_unique<regional_base::RegionalCatalogue>(file_name);
+                        continue;
+                    }
                     serialization::Serializator serializator;
                     serializator.SetSettings(move(file_name));                    
                     serializator.DeserializeFile(catalogue, renderer, router);
                 } else if (request_type == "stat_requests"s && !request_body.AsArray().empty()) {
-                    request_handler::RequestHandler handler(catalogue, renderer);
                     for (const auto& query : request_body.AsArray()) {
                         FillStatRequest(query);
                     }
-                    json::Document document = StatRequestProcess(catalogue, stat_requests_, handler, router);
+                    if (regional_catalogue_) {
+                        json::Print(RegionalStatRequestProcess(*regional_catalogue_, stat_requests_, GetPool()), output);
+                        continue;
+                    }
+                    request_handler::RequestHandler handler(catalogue, renderer);
+                    json::Document document = StatRequestProcess(catalogue, stat_requests_, handler, router, GetPool());
                     json::Print(document, output);
                 } 
             }
         }
 
-        void JsonReader::RuntimeProcessRequests(TransportCatalogue &catalogue, std::istream &input, std::ostream &output, map_renderer::MapRenderer &renderer, const request_handler::RequestHandler &handler)
-        {
-            json::Document request = json::Load(input);
-            transport_router::RouterSettings router_settings;
+        void JsonReader::SetProcessingSettings(const json::Dict& processing_settings) {
+            if (processing_settings.count("worker_count"s)) {
+                const int worker_count = processing_settings.at("worker_count"s).AsInt();
+                if (worker_count < 0) {
+                    throw invalid_argument("Worker count should not be negative"s);
+                }
+                worker_count_ = static_cast<size_t>(worker_count);
+                pool_.reset();
+            }
+        }
 
-            for (const auto& [request_type, request_body] : request.GetRoot().AsDict()) {
-                if (request_type == "base_requests"s && !request_body.AsArray().empty()) {
-                    BaseRequestProcess(catalogue, request_body.AsArray());
-                } else if (request_type == "stat_requests"s && !request_body.AsArray().empty()) {
-                    for (const auto& query : request_body.AsArray()) {
-                        FillStatRequest(query);
+        WorkStealingPool& JsonReader::GetPool() {
+            if (!pool_) {
+                pool_ = make_unique<WorkStealingPool>(worker_count_);
+            }
+            return *pool_;
+        }
+
+        // routing_settings меняют только время ожидания и скорость: веса рёбер пересчитываются в копии маршрутизатора
+        // без построения графа и разбиения
+        bool IsWeightOnlyChange(const transport_router::RouterSettings& current, const transport_router::RouterSettings& next, const json::Dict& routing_settings) {
+            return !routing_settings.count("bus_profiles"s)
+                && next.routing_mode == current.routing_mode
+                && next.landmarks_count == current.landmarks_count
+                && next.overlay_cells_count == current.overlay_cells_count
+                && next.table_file_name == current.table_file_name
+                && next.table_memory_limit == current.table_memory_limit
+                && next.search_limits.settle_limit == current.search_limits.settle_limit
+                && next.search_limits.time_limit == current.search_limits.time_limit;
+        }
+
+        // base_requests меняют только расстояния между известными остановками: остановки сохраняют номера и координаты,
+        // автобусы не меняются, поэтому в копии маршрутизатора пересчитываются веса рёбер автобусов через эти перегоны
+        bool IsDistanceOnlyChange(const TransportCatalogue& catalogue, const json::Array& base_requests) {
+            for (const auto& request : base_requests) {
+                const json::Dict& request_dict = request.AsDict();
+                if (request_dict.at("type"s).AsString() != "Stop"s) {
+                    return false;
+                }
+                const auto stop = catalogue.GetStop(request_dict.at("name"s).AsString());
+                if (!stop || catalogue.GetStopCoordinates(*stop) != GetStopCoordinatesFromRequest(request_dict)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // Перегоны с расстояниями, заданными в base_requests
+        vector<pair<domain::StopId, domain::StopId>> GetChangedDistances(const TransportCatalogue& catalogue, const json::Array& base_requests) {
+            vector<pair<domain::StopId, domain::StopId>> stop_pairs;
+            for (const auto& request : base_requests) {
+                const json::Dict& request_dict = request.AsDict();
+                const auto road_distances = request_dict.find("road_distances"s);
+                if (road_distances == request_dict.end()) {
+                    continue;
+                }
+                const domain::StopId from = *catalogue.GetStop(request_dict.at("name"s).AsString());
+                for (const auto& [stop_to, distance] : road_distances->second.AsDict()) {
+                    stop_pairs.emplace_back(from, *catalogue.GetStop(stop_to));
+                }
+            }
+            return stop_pairs;
+        }
+
+        // Новая версия из текущей и изменений: справочник пересобирается, если есть base_requests, маршрутизатор —
+        // если изменился справочник или routing_settings, остальное разделяется с текущей версией. Если изменились
+        // только расстояния, время ожидания или скорость, маршрутизатор копируется и в копии пересчитываются веса рёбер
+        unique_ptr<const CatalogueVersion> MakeNextVersion(const CatalogueVersion* current, const json::Dict& requests) {
+            const auto base_requests = requests.find("base_requests"s);
+            const auto render_settings = requests.find("render_settings"s);
+            const auto routing_settings = requests.find("routing_settings"s);
+            const bool has_base_requests = base_requests != requests.end() && !base_requests->second.AsArray().empty();
+            const bool has_render_settings = render_settings != requests.end() && !render_settings->second.AsDict().empty();
+            const bool has_routing_settings = routing_settings != requests.end() && !routing_settings->second.AsDict().empty();
+            if (current && !has_base_requests && !has_render_settings && !has_routing_settings) {
+                return nullptr;
+            }
+
+            auto version = make_unique<CatalogueVersion>();
+            version->number = current ? current->number + 1 : 1;
+            if (has_base_requests || !current) {
+                auto catalogue = make_shared<TransportCatalogue>();
+                if (has_base_requests) {
+                    BaseRequestProcess(*catalogue, base_requests->second.AsArray(), current ? current->catalogue.get() : nullptr);
+                } else {
+                    catalogue->Freeze();
+                }
+                version->catalogue = move(catalogue);
+            } else {
+                version->catalogue = current->catalogue;
+            }
+            if (has_render_settings || !current) {
+                auto renderer = make_shared<map_renderer::MapRenderer>();
+                if (has_render_settings) {
+                    SetRenderSettings(*renderer, render_settings->second.AsDict());
+                }
+                version->renderer = move(renderer);
+            } else {
+                version->renderer = current->renderer;
+            }
+            if (has_base_requests || has_routing_settings || !current) {
+                transport_router::RouterSettings settings = current ? current->router->GetRouterSettings() : transport_router::RouterSettings{};
+                if (current) {
+                    settings.table_file_name = current->table_file_name;
+                }
+                if (has_routing_settings) {
+                    SetRouterSettings(settings, routing_settings->second.AsDict());
+                }
+                version->table_file_name = settings.table_file_name;
+                // таблица режима PAGED_TABLE строится заново в файл этой версии, копия читала бы файл текущей версии
+                const bool is_weight_update = current && settings.routing_mode != transport_router::RoutingMode::PAGED_TABLE
+                    && (!has_routing_settings || IsWeightOnlyChange(current->router->GetRouterSettings(), settings, routing_settings->second.AsDict()))
+                    && (!has_base_requests || IsDistanceOnlyChange(*current->catalogue, base_requests->second.AsArray()));
+                if (is_weight_update) {
+                    auto router = make_shared<transport_router::TransportRouter>(*version->catalogue, *current->router);
+                    if (has_routing_settings) {
+                        // пересчитываются все рёбра, в том числе через изменённые перегоны
+                        router->UpdateRouterSettings(settings.bus_wait_time, settings.bus_velocity);
+                    } else {
+                        router->UpdateDistances(GetChangedDistances(*version->catalogue, base_requests->second.AsArray()));
                     }
-                    transport_router::TransportRouter router(catalogue, router_settings);
-                    json::Document document = StatRequestProcess(catalogue, stat_requests_, handler, router);
-                    json::Print(document, output);
-                } else if (request_type == "render_settings"s && !request_body.AsDict().empty()) {
-                    SetRenderSettings(renderer, request_body.AsDict());
-                } else if (request_type == "routing_settings"s && !request_body.AsDict().empty()) {
-                    SetRouterSettings(router_settings, request_body.AsDict());
+                    version->router = move(router);
+                } else if (settings.routing_mode == transport_router::RoutingMode::PAGED_TABLE) {
+                    // закреплённые читателями версии продолжают читать свои файлы
+                    settings.table_file_name += "."s + to_string(version->number);
+                    const string table_file_name = settings.table_file_name;
+                    version->router = shared_ptr<const transport_router::TransportRouter>(new transport_router::TransportRouter(*version->catalogue, settings),
+                        [table_file_name](const transport_router::TransportRouter* router) {
+                            // файл закрывается маршрутизатором до удаления
+                            delete router;
+                            remove(table_file_name.c_str());
+                        });
+                } else {
+                    version->router = make_shared<transport_router::TransportRouter>(*version->catalogue, settings);
+                }
+            } else {
+                version->router = current->router;
+                version->table_file_name = current->table_file_name;
+            }
+            return version;
+        }
+
+        void JsonReader::RuntimeProcessRequests(SnapshotHolder<CatalogueVersion>& versions, istream& input, ostream& output) {
+            json::Document request = json::Load(input);
+            const json::Dict& requests = request.GetRoot().AsDict();
+            if (const auto processing_settings = requests.find("processing_settings"s); processing_settings != requests.end() && !processing_settings->second.AsDict().empty()) {
+                SetProcessingSettings(processing_settings->second.AsDict());
+            }
+
+            // изменения публикуются до ответов, поэтому запросы документа видят их
+            unique_ptr<const CatalogueVersion> next_version;
+            if (versions.IsEmpty()) {
+                next_version = MakeNextVersion(nullptr, requests);
+            } else {
+                const auto current = versions.Acquire();
+                next_version = MakeNextVersion(&*current, requests);
+            }
+            if (next_version) {
+                versions.Publish(move(next_version));
+            }
+
+            if (const auto stat_requests = requests.find("stat_requests"s); stat_requests != requests.end() && !stat_requests->second.AsArray().empty()) {
+                const auto version = versions.Acquire();
+                stat_requests_.clear();
+                for (const auto& query : stat_requests->second.AsArray()) {
+                    FillStatRequest(query);
                 }
+                request_handler::RequestHandler handler(*version->catalogue, *version->renderer);
+                json::Document document = StatRequestProcess(*version->catalogue, stat_requests_, handler, *version->router, GetPool());
+                json::Print(document, output);
+                // ответ отдаётся сразу, не дожидаясь следующего документа
+                output << endl;
             }
         }
 
@@ -286,6 +905,12 @@ namespace transport_catalogue {
                 return RequestType::MAP;
             } else if (request == "Route") {
                 return RequestType::ROUTE;
+            } else if (request == "Analytics") {
+                return RequestType::ANALYTICS;
+            } else if (request == "DirectBuses") {
+                return RequestType::DIRECT_BUSES;
+            } else if (request == "StopSearch") {
+                return RequestType::STOP_SEARCH;
             } else {
                 return RequestType::WTF;
             }
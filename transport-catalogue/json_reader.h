@@ -4,42 +4,92 @@
 #include "json.h"
 #include "json_builder.h"
 #include "map_renderer.h"
+#include "regional_base.h"
 #include "request_handler.h"
+#include "snapshot_holder.h"
 #include "transport_catalogue.h"
 #include "transport_router.h"
+#include "work_stealing_pool.h"
+#include <cstdint>
+#include <string>
+#include <memory>
+#include <optional>
 #include <vector>
 
 namespace transport_catalogue {
     namespace json_reader {
 
         enum class RequestType {
+            ANALYTICS,
             BUS,
+            DIRECT_BUSES,
             MAP,
             ROUTE,
             STOP,
+            STOP_SEARCH,
             WTF
         };
 
         RequestType GetRequestType(std::string_view request);
 
+        enum class StopSearchMode {
+            PREFIX,
+            FUZZY
+        };
+
         struct StatRequest {
             int id = 0;
             RequestType type;
             std::string name;
             std::string from;
             std::string to;
+            std::vector<std::string> via;
+            // ограничения поиска, заданные в запросе вместо ограничений из routing_settings
+            std::optional<int> search_settle_limit;
+            std::optional<int> search_time_limit;
+            // время отправления в минутах от начала суток, с ним маршрут строится с учётом профилей автобусов
+            std::optional<double> departure_time;
+            // поиск остановок: названия, начинающиеся с query, или отличающиеся от него не больше чем на max_distance правок
+            std::string query;
+            StopSearchMode search_mode = StopSearchMode::PREFIX;
+            int max_distance = 2;
+            int limit = 10;
+            // отчёт по значениям RouteInfo всех автобусов
+            domain::BusStatsQuery analytics;
+        };
+
+        // Данные, по которым отвечают на запросы. Версия не изменяется после публикации,
+        // следующие версии разделяют с ней части, которые не изменились
+        struct CatalogueVersion {
+            std::uint64_t number = 0;
+            std::shared_ptr<const TransportCatalogue> catalogue;
+            std::shared_ptr<const map_renderer::MapRenderer> renderer;
+            std::shared_ptr<const transport_router::TransportRouter> router;
+            // файл таблицы из routing_settings. В режиме PAGED_TABLE маршрутизатор каждой версии пишет таблицу в свой файл
+            // с номером версии через точку, и файл удаляется вместе с маршрутизатором, когда его не использует ни одна версия
+            std::string table_file_name;
         };
 
         class JsonReader {
         public:
             void MakeBase(std::istream& input, TransportCatalogue& catalogue, map_renderer::MapRenderer& renderer, transport_router::RouterSettings& router_settings);
             void ProcessRequests(std::istream& input, std::ostream& output, TransportCatalogue& catalogue, map_renderer::MapRenderer& renderer, transport_router::TransportRouter& router);
-            void RuntimeProcessRequests(TransportCatalogue& catalogue, std::istream& input, std::ostream& out, map_renderer::MapRenderer& renderer, const request_handler::RequestHandler& handler);
+            // Обрабатывает документ долго работающего процесса: base_requests, render_settings и routing_settings
+            // собираются в новую версию и публикуются в versions, stat_requests отвечаются по закреплённой текущей версии.
+            // Читатели других потоков продолжают отвечать по своим версиям без блокировок
+            void RuntimeProcessRequests(SnapshotHolder<CatalogueVersion>& versions, std::istream& input, std::ostream& output);
 
         private:
             std::vector<StatRequest> stat_requests_;
+            // исполнители для stat_requests, 0 — по количеству ядер. Задаётся в processing_settings
+            size_t worker_count_ = 0;
+            std::unique_ptr<WorkStealingPool> pool_;
+            // справочник базы, разделённой на регионы, если в serialization_settings задан regions_count
+            std::unique_ptr<regional_base::RegionalCatalogue> regional_catalogue_;
 
             void FillStatRequest(const json::Node& query);
+            void SetProcessingSettings(const json::Dict& processing_settings);
+            WorkStealingPool& GetPool();
         };
 
     } // namespace json_reader
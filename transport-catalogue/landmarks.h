@@ -0,0 +1,137 @@
+#pragma once
+
+#include "graph.h"
+#include "shortest_path_tree.h"
+
+#include <algorithm>
+#include <limits>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+    // Ориентиры для целенаправленного поиска ALT (A*, landmarks, triangle inequality).
+    // Для каждого ориентира L хранятся расстояния d(L, v) и d(v, L) до всех вершин графа,
+    // откуда по неравенству треугольника получается нижняя оценка d(v, t)
+    template <typename Weight>
+    class Landmarks {
+    private:
+        using Graph = DirectedWeightedGraph<Weight>;
+
+    public:
+        // Ориентиры выбираются среди candidates методом наиболее удалённой точки
+        Landmarks(const Graph& graph, const std::vector<VertexId>& candidates, size_t count);
+        Landmarks(size_t vertex_count, std::vector<VertexId>&& landmarks, std::vector<Weight>&& weights_from_landmarks,
+                  std::vector<Weight>&& weights_to_landmarks);
+
+        // Нижняя оценка расстояния from -> to, std::nullopt — to заведомо недостижима из from
+        std::optional<Weight> GetLowerBound(VertexId from, VertexId to) const;
+
+        const std::vector<VertexId>& GetLandmarks() const;
+        const std::vector<Weight>& GetWeightsFromLandmarks() const;
+        const std::vector<Weight>& GetWeightsToLandmarks() const;
+
+    private:
+        static constexpr Weight INFINITE_WEIGHT = std::numeric_limits<Weight>::infinity();
+        // запас на погрешность вычислений, чтобы оценка оставалась нижней
+        static constexpr Weight LOWER_BOUND_FACTOR = 1 - 1e-9;
+
+        size_t vertex_count_ = 0;
+        std::vector<VertexId> landmarks_;
+        // расстояния хранятся построчно: [номер ориентира * vertex_count_ + вершина]
+        std::vector<Weight> weights_from_landmarks_;
+        std::vector<Weight> weights_to_landmarks_;
+
+        static Graph GetReversedGraph(const Graph& graph) {
+            Graph reversed_graph(graph.GetVertexCount());
+            for (VertexId vertex = 0; vertex < graph.GetVertexCount(); ++vertex) {
+                for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
+                    const auto& edge = graph.GetEdge(edge_id);
+                    reversed_graph.AddEdge({edge.to, edge.from, edge.weight});
+                }
+            }
+            return reversed_graph;
+        }
+
+        void AddWeights(const Graph& graph, VertexId from, std::vector<Weight>& weights) const {
+            const ShortestPathTree<Weight> tree(graph, from);
+            for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+                weights.push_back(tree.GetWeight(vertex).value_or(INFINITE_WEIGHT));
+            }
+        }
+    };
+
+    template <typename Weight>
+    Landmarks<Weight>::Landmarks(const Graph& graph, const std::vector<VertexId>& candidates, size_t count)
+        : vertex_count_(graph.GetVertexCount()) {
+        const Graph reversed_graph = GetReversedGraph(graph);
+        count = std::min(count, candidates.size());
+        // расстояние кандидата до ближайшего выбранного ориентира в обе стороны
+        std::vector<Weight> candidate_weights(candidates.size(), INFINITE_WEIGHT);
+        size_t next_candidate = 0;
+        while (landmarks_.size() < count) {
+            const VertexId landmark = candidates[next_candidate];
+            const size_t offset = landmarks_.size() * vertex_count_;
+            landmarks_.push_back(landmark);
+            AddWeights(graph, landmark, weights_from_landmarks_);
+            AddWeights(reversed_graph, landmark, weights_to_landmarks_);
+
+            for (size_t i = 0; i < candidates.size(); ++i) {
+                const Weight round_trip_weight = weights_from_landmarks_[offset + candidates[i]] + weights_to_landmarks_[offset + candidates[i]];
+                candidate_weights[i] = std::min(candidate_weights[i], round_trip_weight);
+            }
+            next_candidate = std::max_element(candidate_weights.begin(), candidate_weights.end()) - candidate_weights.begin();
+        }
+    }
+
+    template <typename Weight>
+    Landmarks<Weight>::Landmarks(size_t vertex_count, std::vector<VertexId>&& landmarks, std::vector<Weight>&& weights_from_landmarks,
+                                 std::vector<Weight>&& weights_to_landmarks)
+        : vertex_count_(vertex_count)
+        , landmarks_(std::move(landmarks))
+        , weights_from_landmarks_(std::move(weights_from_landmarks))
+        , weights_to_landmarks_(std::move(weights_to_landmarks)) {}
+
+    template <typename Weight>
+    std::optional<Weight> Landmarks<Weight>::GetLowerBound(VertexId from, VertexId to) const {
+        Weight lower_bound{};
+        for (size_t offset = 0; offset < weights_from_landmarks_.size(); offset += vertex_count_) {
+            // d(from, to) >= d(from, L) - d(to, L)
+            const Weight from_to_landmark = weights_to_landmarks_[offset + from];
+            const Weight to_to_landmark = weights_to_landmarks_[offset + to];
+            if (to_to_landmark != INFINITE_WEIGHT) {
+                if (from_to_landmark == INFINITE_WEIGHT) {
+                    return std::nullopt;
+                }
+                lower_bound = std::max(lower_bound, from_to_landmark - to_to_landmark);
+            }
+            // d(from, to) >= d(L, to) - d(L, from)
+            const Weight landmark_to_from = weights_from_landmarks_[offset + from];
+            const Weight landmark_to_to = weights_from_landmarks_[offset + to];
+            if (landmark_to_from != INFINITE_WEIGHT) {
+                if (landmark_to_to == INFINITE_WEIGHT) {
+                    return std::nullopt;
+                }
+                lower_bound = std::max(lower_bound, landmark_to_to - landmark_to_from);
+            }
+        }
+        return lower_bound * LOWER_BOUND_FACTOR;
+    }
+
+    template <typename Weight>
+    const std::vector<VertexId>& Landmarks<Weight>::GetLandmarks() const {
+        return landmarks_;
+    }
+
+    template <typename Weight>
+    const std::vector<Weight>& Landmarks<Weight>::GetWeightsFromLandmarks() const {
+        return weights_from_landmarks_;
+    }
+
+    template <typename Weight>
+    const std::vector<Weight>& Landmarks<Weight>::GetWeightsToLandmarks() const {
+        return weights_to_landmarks_;
+    }
+
+}  // namespace graph
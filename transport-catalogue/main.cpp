@@ -13,7 +13,7 @@ using namespace std::literals;
 using namespace transport_catalogue;
 
 void PrintUsage(std::ostream& stream = std::cerr) {
-    stream << "Usage: transport_catalogue [make_base|process_requests]\n"sv;
+    stream << "Usage: transport_catalogue [make_base|process_requests|serve_requests]\n"sv;
 }
 
 int main(int argc, char* argv[]) {
@@ -48,6 +48,21 @@ int main(int argc, char* argv[]) {
             return 3;
         }
         
+    } else if (mode == "serve_requests"sv) {
+        // документы читаются один за другим до конца ввода, изменения каждого публикуются новой версией
+        SnapshotHolder<json_reader::CatalogueVersion> versions;
+        while ((std::cin >> std::ws) && std::cin.peek() != EOF) {
+            try {
+                reader.RuntimeProcessRequests(versions, std::cin, std::cout);
+            } catch (const json::ParsingError& e) {
+                std::cerr << e.what() << std::endl;
+                return 3;
+            } catch (const std::exception& e) {
+                // документ прочитан целиком, ошибочные изменения не публикуются, и следующие документы обрабатываются
+                std::cerr << e.what() << std::endl;
+            }
+        }
+
     } else {
         PrintUsage();
         return 1;
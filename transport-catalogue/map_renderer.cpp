@@ -18,14 +18,14 @@ namespace transport_catalogue {
             return settings_;
         }
 
-        svg::Polyline MapRenderer::RenderRoutes(const domain::Bus* bus, SphereProjector& projector, size_t color_number) const {
+        svg::Polyline MapRenderer::RenderRoutes(const TransportCatalogue& catalogue, const domain::Bus* bus, SphereProjector& projector, size_t color_number) const {
             svg::Polyline route;
             for (const auto& stop : bus->stops) {
-                route.AddPoint(projector(stop->coordinates));
+                route.AddPoint(projector(catalogue.GetStopCoordinates(stop)));
             }
             if (!bus->is_roundtrip) {
                 for (int i = static_cast<int>(bus->stops.size()) - 2; i >= 0; --i) {
-                    route.AddPoint(projector(bus->stops[static_cast<size_t>(i)]->coordinates));
+                    route.AddPoint(projector(catalogue.GetStopCoordinates(bus->stops[static_cast<size_t>(i)])));
                 }
             }
             route.SetFillColor("none");
@@ -38,7 +38,7 @@ namespace transport_catalogue {
 
         svg::Text MapRenderer::RenderRouteName(const domain::Bus* bus, svg::Point stop_coordinates, size_t color_number = 0) const {
             svg::Text route_name;
-            route_name.SetData(bus->name);
+            route_name.SetData(string(bus->name));
             route_name.SetPosition({stop_coordinates.x, stop_coordinates.y});
             route_name.SetOffset(settings_.bus_label_offset);
             route_name.SetFontSize(static_cast<uint32_t>(settings_.bus_label_font_size));
@@ -60,19 +60,19 @@ namespace transport_catalogue {
             return route_name_base;
         }
 
-        svg::Circle MapRenderer::RenderStopCircle(const domain::Stop* stop, SphereProjector& projector) const {
+        svg::Circle MapRenderer::RenderStopCircle(const TransportCatalogue& catalogue, domain::StopId stop, SphereProjector& projector) const {
             svg::Circle stop_circle;
-            stop_circle.SetCenter(projector(stop->coordinates));
+            stop_circle.SetCenter(projector(catalogue.GetStopCoordinates(stop)));
             stop_circle.SetRadius(settings_.stop_radius);
             stop_circle.SetFillColor("white"s);
 
             return stop_circle;
         }
 
-        svg::Text MapRenderer::RenderStopName(const domain::Stop* stop, SphereProjector& projector) const {
+        svg::Text MapRenderer::RenderStopName(const TransportCatalogue& catalogue, domain::StopId stop, SphereProjector& projector) const {
             svg::Text stop_name;
-            stop_name.SetData(stop->name);
-            stop_name.SetPosition(projector(stop->coordinates));
+            stop_name.SetData(string(catalogue.GetStopName(stop)));
+            stop_name.SetPosition(projector(catalogue.GetStopCoordinates(stop)));
             stop_name.SetOffset(settings_.stop_label_offset);
             stop_name.SetFontSize(static_cast<uint32_t>(settings_.stop_label_font_size));
             stop_name.SetFontFamily("Verdana"s);
@@ -81,8 +81,8 @@ namespace transport_catalogue {
             return stop_name;
         }
 
-        svg::Text MapRenderer::RenderStopNameBase(const domain::Stop* stop, SphereProjector& projector) const {
-            svg::Text stop_name_base = RenderStopName(stop, projector);
+        svg::Text MapRenderer::RenderStopNameBase(const TransportCatalogue& catalogue, domain::StopId stop, SphereProjector& projector) const {
+            svg::Text stop_name_base = RenderStopName(catalogue, stop, projector);
             stop_name_base.SetFillColor(settings_.underlayer_color);
             stop_name_base.SetStrokeColor(settings_.underlayer_color);
             stop_name_base.SetStrokeWidth(settings_.underlayer_width);
@@ -92,45 +92,55 @@ namespace transport_catalogue {
             return stop_name_base;
         }
 
-        svg::Document MapRenderer::RenderMap(const map<string_view, const domain::Bus*>* bus_list) const {
+        svg::Document MapRenderer::RenderMap(const TransportCatalogue& catalogue) const {
             svg::Document map;
+            vector<const domain::Bus*> bus_list;
+            bus_list.reserve(catalogue.GetBusesByName().size());
+            for (const domain::BusIndex bus : catalogue.GetBusesByName()) {
+                bus_list.push_back(&catalogue.GetBusByIndex(bus));
+            }
 
-            auto comp = [] (const domain::Stop* lhs, const domain::Stop* rhs) {
-                return lhs->name < rhs->name;
+            auto comp = [&catalogue] (domain::StopId lhs, domain::StopId rhs) {
+                return catalogue.GetStopName(lhs) < catalogue.GetStopName(rhs);
             };
 
-            set<const domain::Stop*, decltype(comp)> stops_list(comp);
-            for (const auto& bus : *bus_list) {
-                stops_list.insert(bus.second->stops.begin(), bus.second->stops.end());
+            set<domain::StopId, decltype(comp)> stops_list(comp);
+            for (const domain::Bus* bus : bus_list) {
+                stops_list.insert(bus->stops.begin(), bus->stops.end());
+            }
+            vector<geo::Coordinates> stops_coordinates;
+            stops_coordinates.reserve(stops_list.size());
+            for (const domain::StopId stop : stops_list) {
+                stops_coordinates.push_back(catalogue.GetStopCoordinates(stop));
             }
-            SphereProjector projector(stops_list.begin(), stops_list.end(), settings_.width, settings_.height, settings_.padding);
+            SphereProjector projector(stops_coordinates.begin(), stops_coordinates.end(), settings_.width, settings_.height, settings_.padding);
             size_t color_number = 0;
-            for (const auto& bus : *bus_list) {
-                if(bus.second->stops.empty()) continue;
-                map.Add(RenderRoutes(bus.second, projector, color_number));
+            for (const domain::Bus* bus : bus_list) {
+                if(bus->stops.empty()) continue;
+                map.Add(RenderRoutes(catalogue, bus, projector, color_number));
                 ++color_number;
             }
 
             color_number = 0;
-            for (const auto& bus : *bus_list) {
-                auto stops = bus.second->stops;
+            for (const domain::Bus* bus : bus_list) {
+                const auto& stops = bus->stops;
                 if(stops.empty()) continue;
-                map.Add(RenderRouteNameBase(bus.second, projector(stops[0]->coordinates)));
-                map.Add(RenderRouteName(bus.second, projector(stops[0]->coordinates), color_number));
-                if (!bus.second->is_roundtrip && stops[0] != stops[stops.size() - 1]) {
-                    map.Add(RenderRouteNameBase(bus.second, projector(stops[stops.size() - 1]->coordinates)));
-                    map.Add(RenderRouteName(bus.second, projector(stops[stops.size() - 1]->coordinates), color_number));
+                map.Add(RenderRouteNameBase(bus, projector(catalogue.GetStopCoordinates(stops[0]))));
+                map.Add(RenderRouteName(bus, projector(catalogue.GetStopCoordinates(stops[0])), color_number));
+                if (!bus->is_roundtrip && stops[0] != stops[stops.size() - 1]) {
+                    map.Add(RenderRouteNameBase(bus, projector(catalogue.GetStopCoordinates(stops[stops.size() - 1]))));
+                    map.Add(RenderRouteName(bus, projector(catalogue.GetStopCoordinates(stops[stops.size() - 1])), color_number));
                 }
                 ++color_number;
             }
             
             for (const auto& stop : stops_list) {
-                map.Add(RenderStopCircle(stop, projector));
+                map.Add(RenderStopCircle(catalogue, stop, projector));
             }
 
             for (const auto& stop : stops_list) {
-                map.Add(RenderStopNameBase(stop, projector));
-                map.Add(RenderStopName(stop, projector));
+                map.Add(RenderStopNameBase(catalogue, stop, projector));
+                map.Add(RenderStopName(catalogue, stop, projector));
             }
             
             return map;
@@ -8,6 +8,7 @@
 #include <map>
 #include <string_view>
 #include "svg.h"
+#include "transport_catalogue.h"
 #include <utility>
 #include <vector>
 
@@ -30,17 +31,17 @@ namespace transport_catalogue {
                 // Находим точки с минимальной и максимальной долготой
                 const auto [left_it, right_it]
                     = std::minmax_element(points_begin, points_end, [](auto lhs, auto rhs) {
-                        return lhs->coordinates.lng < rhs->coordinates.lng;
+                        return lhs.lng < rhs.lng;
                     });
-                min_lon_ = (*left_it)->coordinates.lng;
-                const double max_lon = (*right_it)->coordinates.lng;
+                min_lon_ = left_it->lng;
+                const double max_lon = right_it->lng;
                 // Находим точки с минимальной и максимальной широтой
                 const auto [bottom_it, top_it]
                     = std::minmax_element(points_begin, points_end, [](auto lhs, auto rhs) {
-                        return lhs->coordinates.lat < rhs->coordinates.lat;
+                        return lhs.lat < rhs.lat;
                     });
-                const double min_lat = (*bottom_it)->coordinates.lat;
-                max_lat_ = (*top_it)->coordinates.lat;
+                const double min_lat = bottom_it->lat;
+                max_lat_ = top_it->lat;
                 // Вычисляем коэффициент масштабирования вдоль координаты x
                 std::optional<double> width_zoom;
                 if (!IsZero(max_lon - min_lon_)) {
@@ -113,17 +114,17 @@ namespace transport_catalogue {
             void SetSettings(RenderSettings&& settings);
             const RenderSettings GetSettings() const;
 
-            svg::Document RenderMap(const std::map<std::string_view, const domain::Bus*>* bus_list) const;
+            svg::Document RenderMap(const TransportCatalogue& catalogue) const;
 
         private:
             RenderSettings settings_;
 
-            svg::Polyline RenderRoutes(const domain::Bus* bus, SphereProjector& projector, size_t color_number) const;
+            svg::Polyline RenderRoutes(const TransportCatalogue& catalogue, const domain::Bus* bus, SphereProjector& projector, size_t color_number) const;
             svg::Text RenderRouteName(const domain::Bus* bus, svg::Point stop_coordinates, size_t color_number) const;
             svg::Text RenderRouteNameBase(const domain::Bus* bus, svg::Point stop_coordinates) const;
-            svg::Circle RenderStopCircle(const domain::Stop* stop, SphereProjector& projector) const;
-            svg::Text RenderStopName(const domain::Stop* stop, SphereProjector& projector) const;
-            svg::Text RenderStopNameBase(const domain::Stop* stop, SphereProjector& projector) const;
+            svg::Circle RenderStopCircle(const TransportCatalogue& catalogue, domain::StopId stop, SphereProjector& projector) const;
+            svg::Text RenderStopName(const TransportCatalogue& catalogue, domain::StopId stop, SphereProjector& projector) const;
+            svg::Text RenderStopNameBase(const TransportCatalogue& catalogue, domain::StopId stop, SphereProjector& projector) const;
         };
 
     } // namespace map_renderer
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace transport_catalogue {
+    namespace detail {
+
+        // Хранилище имён: строки записываются подряд в крупные блоки без отдельного выделения памяти на каждую.
+        // Блоки не перемещаются при добавлении строк, поэтому возвращённые string_view остаются действительными
+        // всё время жизни хранилища
+        class NameArena {
+        public:
+            NameArena() = default;
+            // Хранилище, в котором названия общей длиной до capacity записываются в один блок
+            explicit NameArena(size_t capacity);
+
+            std::string_view Add(std::string_view name);
+
+        private:
+            static constexpr size_t BLOCK_SIZE = 1 << 16;
+
+            std::vector<std::unique_ptr<char[]>> blocks_;
+            size_t block_capacity_ = BLOCK_SIZE;
+            size_t block_used_ = BLOCK_SIZE;
+        };
+
+        inline NameArena::NameArena(size_t capacity) {
+            if (capacity > BLOCK_SIZE) {
+                blocks_.push_back(std::make_unique<char[]>(capacity));
+                block_capacity_ = capacity;
+                block_used_ = 0;
+            }
+        }
+
+        inline std::string_view NameArena::Add(std::string_view name) {
+            if (name.empty()) {
+                return {};
+            }
+            // строка длиннее блока получает собственный блок, следующие строки пишутся в новый блок
+            if (name.size() > BLOCK_SIZE) {
+                blocks_.push_back(std::make_unique<char[]>(name.size()));
+                std::memcpy(blocks_.back().get(), name.data(), name.size());
+                block_capacity_ = block_used_ = BLOCK_SIZE;
+                return {blocks_.back().get(), name.size()};
+            }
+            if (block_capacity_ - block_used_ < name.size()) {
+                blocks_.push_back(std::make_unique<char[]>(BLOCK_SIZE));
+                block_capacity_ = BLOCK_SIZE;
+                block_used_ = 0;
+            }
+            char* data = blocks_.back().get() + block_used_;
+            std::memcpy(data, name.data(), name.size());
+            block_used_ += name.size();
+            return {data, name.size()};
+        }
+
+    } // namespace detail
+} // namespace transport_catalogue
@@ -0,0 +1,246 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace transport_catalogue {
+    namespace detail {
+
+        // Префиксное дерево неизменного набора различных названий в трёх массивах. Вершины пронумерованы в порядке
+        // обхода в ширину, поэтому дети вершины идут подряд: дети v — [child_offsets[v], child_offsets[v + 1]),
+        // упорядоченные по байту labels. В ids записан номер названия, которое заканчивается в вершине.
+        // Названия сравниваются побайтно, буква не из ASCII в UTF-8 даёт расстояние до двух правок
+        class NameTrie {
+        public:
+            static constexpr std::uint32_t NOT_FOUND = UINT32_MAX;
+
+            NameTrie() = default;
+            // Дерево, сохранённое ранее
+            NameTrie(std::vector<std::uint32_t> child_offsets, std::string labels, std::vector<std::uint32_t> ids);
+
+            // ids[i] — номер названия names[i], названия не должны повторяться
+            void Build(const std::vector<std::string_view>& names, const std::vector<std::uint32_t>& ids);
+
+            // Номера до limit названий, начинающихся с prefix, в порядке названий
+            std::vector<std::uint32_t> FindByPrefix(std::string_view prefix, size_t limit) const;
+            // Номера до limit названий, расстояние Левенштейна от которых до query не больше max_distance,
+            // по возрастанию расстояния, при равном расстоянии — в порядке названий. Обходятся только вершины,
+            // префикс которых может уложиться в max_distance, поэтому время поиска не растёт вместе с набором
+            std::vector<std::uint32_t> FindSimilar(std::string_view query, size_t max_distance, size_t limit) const;
+
+            bool IsEmpty() const;
+            const std::vector<std::uint32_t>& GetChildOffsets() const;
+            const std::string& GetLabels() const;
+            const std::vector<std::uint32_t>& GetIds() const;
+
+        private:
+            std::vector<std::uint32_t> child_offsets_;
+            std::string labels_;
+            std::vector<std::uint32_t> ids_;
+
+            std::uint32_t FindChild(std::uint32_t node, char label) const;
+        };
+
+        inline NameTrie::NameTrie(std::vector<std::uint32_t> child_offsets, std::string labels, std::vector<std::uint32_t> ids)
+            : child_offsets_(std::move(child_offsets))
+            , labels_(std::move(labels))
+            , ids_(std::move(ids)) {
+            if (ids_.size() != labels_.size() || (!ids_.empty() && child_offsets_.size() != ids_.size() + 1)) {
+                throw std::invalid_argument("Trie arrays should describe the same nodes");
+            }
+        }
+
+        inline void NameTrie::Build(const std::vector<std::string_view>& names, const std::vector<std::uint32_t>& ids) {
+            std::vector<std::uint32_t> order(names.size());
+            for (std::uint32_t i = 0; i < order.size(); ++i) {
+                order[i] = i;
+            }
+            std::sort(order.begin(), order.end(), [&names](std::uint32_t lhs, std::uint32_t rhs) {
+                return names[lhs] < names[rhs];
+            });
+
+            // вершина задаёт отрезок упорядоченных названий с общим префиксом длины depth
+            struct Range {
+                size_t begin;
+                size_t end;
+                size_t depth;
+            };
+            child_offsets_.clear();
+            labels_.assign(1, '\0');
+            ids_.assign(1, NOT_FOUND);
+            std::vector<Range> ranges{{0, order.size(), 0}};
+            for (size_t node = 0; node < ranges.size(); ++node) {
+                auto [begin, end, depth] = ranges[node];
+                child_offsets_.push_back(static_cast<std::uint32_t>(ranges.size()));
+                // более короткое название идёт первым и заканчивается в самой вершине
+                if (begin < end && names[order[begin]].size() == depth) {
+                    ids_[node] = ids[order[begin]];
+                    ++begin;
+                }
+                while (begin < end) {
+                    const char label = names[order[begin]][depth];
+                    size_t child_end = begin + 1;
+                    while (child_end < end && names[order[child_end]][depth] == label) {
+                        ++child_end;
+                    }
+                    ranges.push_back({begin, child_end, depth + 1});
+                    labels_.push_back(label);
+                    ids_.push_back(NOT_FOUND);
+                    begin = child_end;
+                }
+            }
+            child_offsets_.push_back(static_cast<std::uint32_t>(ranges.size()));
+        }
+
+        inline std::vector<std::uint32_t> NameTrie::FindByPrefix(std::string_view prefix, size_t limit) const {
+            std::vector<std::uint32_t> result;
+            if (ids_.empty() || limit == 0) {
+                return result;
+            }
+            std::uint32_t node = 0;
+            for (const char label : prefix) {
+                node = FindChild(node, label);
+                if (node == NOT_FOUND) {
+                    return result;
+                }
+            }
+
+            // дети кладутся в стек с конца, чтобы названия находились по порядку
+            std::vector<std::uint32_t> stack{node};
+            while (!stack.empty() && result.size() < limit) {
+                node = stack.back();
+                stack.pop_back();
+                if (ids_[node] != NOT_FOUND) {
+                    result.push_back(ids_[node]);
+                }
+                for (std::uint32_t child = child_offsets_[node + 1]; child > child_offsets_[node]; --child) {
+                    stack.push_back(child - 1);
+                }
+            }
+            return result;
+        }
+
+        inline std::vector<std::uint32_t> NameTrie::FindSimilar(std::string_view query, size_t max_distance, size_t limit) const {
+            std::vector<std::uint32_t> result;
+            if (ids_.empty() || limit == 0) {
+                return result;
+            }
+
+            // строка матрицы Левенштейна для вершины глубины depth — rows[depth * width, (depth + 1) * width)
+            const size_t width = query.size() + 1;
+            std::vector<size_t> rows(width);
+            for (size_t j = 0; j < width; ++j) {
+                rows[j] = j;
+            }
+            // найденные названия по расстояниям, внутри расстояния — в порядке обхода, то есть названий
+            std::vector<std::vector<std::uint32_t>> found;
+            const auto add_found = [&found](size_t distance, std::uint32_t id) {
+                if (found.size() <= distance) {
+                    found.resize(distance + 1);
+                }
+                found[distance].push_back(id);
+            };
+            // наибольшее расстояние, с которым название ещё попадает в ответ
+            size_t bound = max_distance;
+            bool is_bound_reached = false;
+
+            std::vector<std::pair<std::uint32_t, size_t>> stack;
+            for (std::uint32_t child = child_offsets_[1]; child > child_offsets_[0]; --child) {
+                stack.push_back({child - 1, 1});
+            }
+            if (ids_[0] != NOT_FOUND && query.size() <= max_distance) {
+                add_found(query.size(), ids_[0]);
+            }
+            while (!stack.empty() && !is_bound_reached) {
+                const auto [node, depth] = stack.back();
+                stack.pop_back();
+                if (rows.size() < (depth + 1) * width) {
+                    rows.resize((depth + 1) * width);
+                }
+                const size_t* parent_row = rows.data() + (depth - 1) * width;
+                size_t* row = rows.data() + depth * width;
+                // ячейки дальше bound от диагонали больше bound, поэтому считаются только ячейки полосы [low, high],
+                // а соседние с ней получают bound + 1 для следующей строки
+                const size_t low = depth > bound ? depth - bound : 1;
+                const size_t high = std::min(width - 1, depth + bound);
+                row[0] = depth;
+                if (low > 1) {
+                    row[low - 1] = bound + 1;
+                }
+                size_t row_min = row[0];
+                for (size_t j = low; j <= high; ++j) {
+                    row[j] = std::min({parent_row[j] + 1, row[j - 1] + 1, parent_row[j - 1] + (query[j - 1] != labels_[node])});
+                    row_min = std::min(row_min, row[j]);
+                }
+                if (high + 1 < width) {
+                    row[high + 1] = bound + 1;
+                }
+                const bool is_last_in_band = width == 1 || (low <= high && high == width - 1);
+
+                if (ids_[node] != NOT_FOUND && is_last_in_band && row[width - 1] <= bound) {
+                    const size_t distance = row[width - 1];
+                    add_found(distance, ids_[node]);
+                    size_t found_count = 0;
+                    for (size_t d = 0; d <= distance; ++d) {
+                        found_count += found[d].size();
+                    }
+                    if (found_count >= limit) {
+                        // названия с тем же расстоянием дальше по порядку уже не попадут в ответ
+                        if (distance == 0) {
+                            is_bound_reached = true;
+                        } else {
+                            bound = distance - 1;
+                        }
+                    }
+                }
+                if (row_min <= bound) {
+                    for (std::uint32_t child = child_offsets_[node + 1]; child > child_offsets_[node]; --child) {
+                        stack.push_back({child - 1, depth + 1});
+                    }
+                }
+            }
+
+            for (const auto& ids : found) {
+                for (const std::uint32_t id : ids) {
+                    if (result.size() == limit) {
+                        return result;
+                    }
+                    result.push_back(id);
+                }
+            }
+            return result;
+        }
+
+        inline bool NameTrie::IsEmpty() const {
+            return ids_.empty();
+        }
+
+        inline const std::vector<std::uint32_t>& NameTrie::GetChildOffsets() const {
+            return child_offsets_;
+        }
+
+        inline const std::string& NameTrie::GetLabels() const {
+            return labels_;
+        }
+
+        inline const std::vector<std::uint32_t>& NameTrie::GetIds() const {
+            return ids_;
+        }
+
+        inline std::uint32_t NameTrie::FindChild(std::uint32_t node, char label) const {
+            const auto begin = labels_.begin() + child_offsets_[node];
+            const auto end = labels_.begin() + child_offsets_[node + 1];
+            // названия упорядочены как string_view, то есть по байтам без знака
+            const auto it = std::lower_bound(begin, end, label, [](char lhs, char rhs) {
+                return static_cast<unsigned char>(lhs) < static_cast<unsigned char>(rhs);
+            });
+            return it != end && *it == label ? static_cast<std::uint32_t>(it - labels_.begin()) : NOT_FOUND;
+        }
+
+    } // namespace detail
+} // namespace transport_catalogue
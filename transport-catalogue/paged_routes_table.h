@@ -0,0 +1,210 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+#include "shortest_path_tree.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <ios>
+#include <limits>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+    // Таблица маршрутов Router, хранящаяся в файле. Строка таблицы (маршруты из одной вершины) записывается
+    // как vertex_count весов и vertex_count последних рёбер, строки объединяются в страницы.
+    // При построении в памяти держится одна страница, при запросах — кэш страниц с вытеснением давно не используемых
+    // (LRU) и упреждающим чтением следующих страниц, размер кэша ограничен memory_limit байт.
+    // Путь восстанавливается по одной строке так же, как в Router::BuildRoute
+    template <typename Weight>
+    class PagedRoutesTable {
+    private:
+        using Graph = DirectedWeightedGraph<Weight>;
+
+    public:
+        // Строит строки таблицы поиском Дейкстры из каждой вершины и записывает их в файл
+        static void Write(const Graph& graph, const std::string& file_name, size_t memory_limit);
+
+        PagedRoutesTable(const Graph& graph, const std::string& file_name, size_t memory_limit);
+
+        std::optional<typename Router<Weight>::RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+
+    private:
+        static constexpr std::uint64_t FILE_SIGNATURE = 0x31454c4241545452;  // "RTTABLE1"
+        static constexpr std::uint32_t NO_EDGE = std::numeric_limits<std::uint32_t>::max();
+        static constexpr Weight INFINITE_WEIGHT = std::numeric_limits<Weight>::infinity();
+        // страница — не меньше одной строки и не больше мегабайта, если строка меньше
+        static constexpr size_t PAGE_SIZE = 1 << 20;
+        static constexpr size_t READAHEAD_PAGES = 1;
+
+        struct Header {
+            std::uint64_t signature;
+            std::uint64_t vertex_count;
+            std::uint64_t rows_per_page;
+        };
+
+        struct Page {
+            std::vector<char> data;
+            std::list<size_t>::iterator lru_position;
+        };
+
+        const Graph& graph_;
+        size_t vertex_count_ = 0;
+        size_t rows_per_page_ = 1;
+        size_t page_count_ = 0;
+        size_t max_cached_pages_ = 1;
+
+        mutable std::mutex mutex_;
+        mutable std::ifstream input_;
+        mutable std::unordered_map<size_t, Page> cached_pages_;
+        // номера страниц от недавно использованной к давно не используемой
+        mutable std::list<size_t> lru_pages_;
+
+        static size_t GetRowSize(size_t vertex_count) {
+            return vertex_count * (sizeof(Weight) + sizeof(std::uint32_t));
+        }
+
+        static size_t GetRowsPerPage(size_t vertex_count, size_t memory_limit) {
+            const size_t row_size = std::max<size_t>(1, GetRowSize(vertex_count));
+            const size_t page_size = std::min(PAGE_SIZE, memory_limit);
+            return std::max<size_t>(1, page_size / row_size);
+        }
+
+        size_t GetPageSize(size_t page) const {
+            const size_t rows = std::min(rows_per_page_, vertex_count_ - page * rows_per_page_);
+            return rows * GetRowSize(vertex_count_);
+        }
+
+        // Читает страницу и следующие за ней страницы, которых нет в кэше, одним чтением файла
+        const Page& LoadPage(size_t page) const {
+            if (const auto it = cached_pages_.find(page); it != cached_pages_.end()) {
+                lru_pages_.splice(lru_pages_.begin(), lru_pages_, it->second.lru_position);
+                return it->second;
+            }
+
+            size_t last_page = page;
+            while (last_page + 1 < page_count_ && last_page - page < READAHEAD_PAGES
+                   && last_page - page + 1 < max_cached_pages_ && !cached_pages_.count(last_page + 1)) {
+                ++last_page;
+            }
+            const size_t page_size = GetRowSize(vertex_count_) * rows_per_page_;
+            std::vector<char> buffer(page_size * (last_page - page) + GetPageSize(last_page));
+            input_.seekg(sizeof(Header) + page * page_size);
+            if (!input_.read(buffer.data(), buffer.size())) {
+                throw std::ios_base::failure("Failed to read the routes table");
+            }
+
+            const size_t loaded_pages = last_page - page + 1;
+            while (!lru_pages_.empty() && cached_pages_.size() + loaded_pages > max_cached_pages_) {
+                cached_pages_.erase(lru_pages_.back());
+                lru_pages_.pop_back();
+            }
+            // прочитанные заранее страницы помещаются в конец очереди и вытесняются первыми, если не понадобятся
+            for (size_t i = 0; i < loaded_pages; ++i) {
+                const auto begin = buffer.begin() + i * page_size;
+                Page& cached_page = cached_pages_[page + i];
+                cached_page.data.assign(begin, begin + GetPageSize(page + i));
+                cached_page.lru_position = i == 0 ? lru_pages_.insert(lru_pages_.begin(), page)
+                                                  : lru_pages_.insert(lru_pages_.end(), page + i);
+            }
+            return cached_pages_.at(page);
+        }
+    };
+
+    template <typename Weight>
+    void PagedRoutesTable<Weight>::Write(const Graph& graph, const std::string& file_name, size_t memory_limit) {
+        std::ofstream output(file_name, std::ios::binary);
+        if (!output) {
+            throw std::ios_base::failure("Failed to create a file " + file_name);
+        }
+        const size_t vertex_count = graph.GetVertexCount();
+        const Header header{FILE_SIGNATURE, vertex_count, GetRowsPerPage(vertex_count, memory_limit)};
+        output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        std::vector<char> page;
+        page.reserve(header.rows_per_page * GetRowSize(vertex_count));
+        std::vector<Weight> weights(vertex_count);
+        std::vector<std::uint32_t> prev_edges(vertex_count);
+        for (VertexId from = 0; from < vertex_count; ++from) {
+            const ShortestPathTree<Weight> tree(graph, from);
+            const auto& routes_internal_data = tree.GetRoutesInternalData();
+            for (VertexId to = 0; to < vertex_count; ++to) {
+                const auto& route_internal_data = routes_internal_data[to];
+                weights[to] = route_internal_data ? route_internal_data->weight : INFINITE_WEIGHT;
+                prev_edges[to] = route_internal_data && route_internal_data->prev_edge
+                    ? static_cast<std::uint32_t>(*route_internal_data->prev_edge) : NO_EDGE;
+            }
+            const char* weights_data = reinterpret_cast<const char*>(weights.data());
+            const char* prev_edges_data = reinterpret_cast<const char*>(prev_edges.data());
+            page.insert(page.end(), weights_data, weights_data + vertex_count * sizeof(Weight));
+            page.insert(page.end(), prev_edges_data, prev_edges_data + vertex_count * sizeof(std::uint32_t));
+            if ((from + 1) % header.rows_per_page == 0 || from + 1 == vertex_count) {
+                output.write(page.data(), page.size());
+                page.clear();
+            }
+        }
+        if (!output) {
+            throw std::ios_base::failure("Failed to write a file " + file_name);
+        }
+    }
+
+    template <typename Weight>
+    PagedRoutesTable<Weight>::PagedRoutesTable(const Graph& graph, const std::string& file_name, size_t memory_limit)
+        : graph_(graph), input_(file_name, std::ios::binary) {
+        if (!input_) {
+            throw std::ios_base::failure("Failed to open a file " + file_name);
+        }
+        Header header{};
+        input_.read(reinterpret_cast<char*>(&header), sizeof(header));
+        if (!input_ || header.signature != FILE_SIGNATURE || header.vertex_count != graph.GetVertexCount() || header.rows_per_page == 0) {
+            throw std::runtime_error("The routes table file " + file_name + " does not match the graph");
+        }
+        vertex_count_ = header.vertex_count;
+        rows_per_page_ = header.rows_per_page;
+        page_count_ = (vertex_count_ + rows_per_page_ - 1) / rows_per_page_;
+        max_cached_pages_ = std::max<size_t>(1, memory_limit / std::max<size_t>(1, GetRowSize(vertex_count_) * rows_per_page_));
+    }
+
+    template <typename Weight>
+    std::optional<typename Router<Weight>::RouteInfo> PagedRoutesTable<Weight>::BuildRoute(VertexId from, VertexId to) const {
+        if (from >= vertex_count_ || to >= vertex_count_) {
+            throw std::out_of_range("Vertex is out of range");
+        }
+        std::lock_guard guard(mutex_);
+        const Page& page = LoadPage(from / rows_per_page_);
+        const char* row = page.data.data() + (from % rows_per_page_) * GetRowSize(vertex_count_);
+        const auto get_weight = [row](VertexId vertex) {
+            Weight weight;
+            std::memcpy(&weight, row + vertex * sizeof(Weight), sizeof(Weight));
+            return weight;
+        };
+        const char* prev_edges = row + vertex_count_ * sizeof(Weight);
+        const auto get_prev_edge = [prev_edges](VertexId vertex) {
+            std::uint32_t edge_id;
+            std::memcpy(&edge_id, prev_edges + vertex * sizeof(std::uint32_t), sizeof(std::uint32_t));
+            return edge_id;
+        };
+
+        const Weight weight = get_weight(to);
+        if (weight == INFINITE_WEIGHT) {
+            return std::nullopt;
+        }
+        std::vector<EdgeId> edges;
+        for (std::uint32_t edge_id = get_prev_edge(to); edge_id != NO_EDGE; edge_id = get_prev_edge(graph_.GetEdge(edge_id).from)) {
+            edges.push_back(edge_id);
+        }
+        std::reverse(edges.begin(), edges.end());
+
+        return typename Router<Weight>::RouteInfo{weight, std::move(edges)};
+    }
+
+}  // namespace graph
@@ -0,0 +1,288 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+#include "search_budget.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+    // Оверлей разбиения графа на ячейки в духе customizable route planning.
+    // Входы ячейки — концы рёбер, приходящих из других ячеек, выходы — начала рёбер, уходящих в другие ячейки.
+    // Для каждой ячейки хранится клика: кратчайшие расстояния от её входов до выходов по рёбрам внутри ячейки.
+    // Разбиение и списки граничных вершин не зависят от весов, поэтому при изменении весов достаточно
+    // пересчитать клики (Customize), что делается параллельно по ячейкам.
+    // Запрос — поиск Дейкстры по ячейкам начала и конца пути целиком и по кликам остальных ячеек
+    template <typename Weight>
+    class PartitionOverlay {
+    private:
+        using Graph = DirectedWeightedGraph<Weight>;
+
+    public:
+        struct Cell {
+            std::vector<VertexId> entry_vertices;
+            std::vector<VertexId> exit_vertices;
+            // матрица entry_vertices.size() x exit_vertices.size() по строкам, бесконечность — пути нет
+            std::vector<Weight> clique_weights;
+        };
+
+        PartitionOverlay(const Graph& graph, std::vector<std::uint32_t>&& vertex_cells, size_t cell_count);
+        PartitionOverlay(const Graph& graph, std::vector<std::uint32_t>&& vertex_cells, std::vector<Cell>&& cells);
+
+        // Пересчитывает клики ячеек под текущие веса рёбер графа
+        void Customize();
+
+        // Бросает SearchBudgetExceeded, если поиск исчерпал budget
+        std::optional<typename Router<Weight>::RouteInfo> BuildRoute(VertexId from, VertexId to, const SearchBudget& budget = {}) const;
+
+        const std::vector<std::uint32_t>& GetVertexCells() const;
+        const std::vector<Cell>& GetCells() const;
+
+    private:
+        static constexpr Weight INFINITE_WEIGHT = std::numeric_limits<Weight>::infinity();
+        static constexpr std::uint32_t NOT_ENTRY = UINT32_MAX;
+
+        using QueueItem = std::pair<Weight, VertexId>;
+        using Queue = std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>>;
+
+        // Как попали в вершину при поиске по оверлею: по ребру графа или по ребру клики из входа from
+        struct OverlayStep {
+            VertexId from;
+            std::optional<EdgeId> edge;
+        };
+
+        const Graph& graph_;
+        std::vector<std::uint32_t> vertex_cells_;
+        std::vector<Cell> cells_;
+        std::vector<std::vector<VertexId>> cell_vertices_;
+        // номер вершины в списке вершин её ячейки и в списке входов ячейки
+        std::vector<std::uint32_t> local_indexes_;
+        std::vector<std::uint32_t> entry_indexes_;
+
+        void IndexCells() {
+            cell_vertices_.assign(cells_.size(), {});
+            local_indexes_.assign(vertex_cells_.size(), 0);
+            entry_indexes_.assign(vertex_cells_.size(), NOT_ENTRY);
+            for (VertexId vertex = 0; vertex < vertex_cells_.size(); ++vertex) {
+                auto& vertices = cell_vertices_.at(vertex_cells_[vertex]);
+                local_indexes_[vertex] = static_cast<std::uint32_t>(vertices.size());
+                vertices.push_back(vertex);
+            }
+            for (const Cell& cell : cells_) {
+                for (size_t i = 0; i < cell.entry_vertices.size(); ++i) {
+                    entry_indexes_.at(cell.entry_vertices[i]) = static_cast<std::uint32_t>(i);
+                }
+            }
+        }
+
+        // Дейкстра внутри одной ячейки, результат индексирован локальными номерами вершин
+        std::vector<std::optional<RouteInternalData<Weight>>> SearchInCell(VertexId from, std::optional<VertexId> to = std::nullopt) const {
+            const std::uint32_t cell = vertex_cells_[from];
+            std::vector<std::optional<RouteInternalData<Weight>>> routes(cell_vertices_[cell].size());
+            std::vector<bool> is_settled(routes.size());
+            Queue queue;
+            routes[local_indexes_[from]] = RouteInternalData<Weight>{Weight{}, std::nullopt};
+            queue.push({Weight{}, from});
+            while (!queue.empty()) {
+                const auto [weight, vertex] = queue.top();
+                queue.pop();
+                if (is_settled[local_indexes_[vertex]]) {
+                    continue;
+                }
+                is_settled[local_indexes_[vertex]] = true;
+                if (to && vertex == *to) {
+                    break;
+                }
+                for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+                    const auto& edge = graph_.GetEdge(edge_id);
+                    if (vertex_cells_[edge.to] != cell) {
+                        continue;
+                    }
+                    auto& route = routes[local_indexes_[edge.to]];
+                    const Weight candidate_weight = weight + edge.weight;
+                    if (!route || candidate_weight < route->weight) {
+                        route = RouteInternalData<Weight>{candidate_weight, edge_id};
+                        queue.push({candidate_weight, edge.to});
+                    }
+                }
+            }
+            return routes;
+        }
+
+        void CustomizeCell(Cell& cell) const {
+            const size_t exit_count = cell.exit_vertices.size();
+            cell.clique_weights.assign(cell.entry_vertices.size() * exit_count, INFINITE_WEIGHT);
+            for (size_t i = 0; i < cell.entry_vertices.size(); ++i) {
+                const auto routes = SearchInCell(cell.entry_vertices[i]);
+                for (size_t j = 0; j < exit_count; ++j) {
+                    if (const auto& route = routes[local_indexes_[cell.exit_vertices[j]]]) {
+                        cell.clique_weights[i * exit_count + j] = route->weight;
+                    }
+                }
+            }
+        }
+
+        // Восстанавливает рёбра графа, из которых состоит ребро клики from -> to
+        void UnpackCliqueEdge(VertexId from, VertexId to, std::vector<EdgeId>& edges) const {
+            const auto routes = SearchInCell(from, to);
+            const size_t path_begin = edges.size();
+            for (std::optional<EdgeId> edge_id = routes[local_indexes_[to]]->prev_edge;
+                 edge_id;
+                 edge_id = routes[local_indexes_[graph_.GetEdge(*edge_id).from]]->prev_edge)
+            {
+                edges.push_back(*edge_id);
+            }
+            std::reverse(edges.begin() + path_begin, edges.end());
+        }
+    };
+
+    template <typename Weight>
+    PartitionOverlay<Weight>::PartitionOverlay(const Graph& graph, std::vector<std::uint32_t>&& vertex_cells, size_t cell_count)
+        : graph_(graph), vertex_cells_(std::move(vertex_cells)), cells_(cell_count) {
+        if (vertex_cells_.size() != graph.GetVertexCount()) {
+            throw std::invalid_argument("Every vertex should be assigned to a cell");
+        }
+        std::vector<bool> is_entry(graph.GetVertexCount()), is_exit(graph.GetVertexCount());
+        for (const auto& edge : graph.GetEdges()) {
+            if (vertex_cells_[edge.from] != vertex_cells_[edge.to]) {
+                is_exit[edge.from] = is_entry[edge.to] = true;
+            }
+        }
+        for (VertexId vertex = 0; vertex < graph.GetVertexCount(); ++vertex) {
+            Cell& cell = cells_.at(vertex_cells_[vertex]);
+            if (is_entry[vertex]) {
+                cell.entry_vertices.push_back(vertex);
+            }
+            if (is_exit[vertex]) {
+                cell.exit_vertices.push_back(vertex);
+            }
+        }
+        IndexCells();
+        Customize();
+    }
+
+    template <typename Weight>
+    PartitionOverlay<Weight>::PartitionOverlay(const Graph& graph, std::vector<std::uint32_t>&& vertex_cells, std::vector<Cell>&& cells)
+        : graph_(graph), vertex_cells_(std::move(vertex_cells)), cells_(std::move(cells)) {
+        IndexCells();
+    }
+
+    template <typename Weight>
+    void PartitionOverlay<Weight>::Customize() {
+        for (const auto& edge : graph_.GetEdges()) {
+            if (edge.weight < Weight{}) {
+                throw std::domain_error("Edges' weights should be non-negative");
+            }
+        }
+
+        // одна задача на ячейку, ячейки разбирают потоки пула
+        const size_t thread_count = std::max<size_t>(1, std::min<size_t>(std::thread::hardware_concurrency(), cells_.size()));
+        std::atomic<size_t> next_cell{0};
+        const auto customize_cells = [this, &next_cell] {
+            for (size_t cell = next_cell++; cell < cells_.size(); cell = next_cell++) {
+                CustomizeCell(cells_[cell]);
+            }
+        };
+        std::vector<std::thread> threads;
+        for (size_t i = 1; i < thread_count; ++i) {
+            threads.emplace_back(customize_cells);
+        }
+        customize_cells();
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+
+    template <typename Weight>
+    std::optional<typename Router<Weight>::RouteInfo> PartitionOverlay<Weight>::BuildRoute(VertexId from, VertexId to, const SearchBudget& budget) const {
+        const std::uint32_t from_cell = vertex_cells_.at(from);
+        const std::uint32_t to_cell = vertex_cells_.at(to);
+        std::vector<std::optional<Weight>> weights(graph_.GetVertexCount());
+        std::vector<std::optional<OverlayStep>> steps(graph_.GetVertexCount());
+        std::vector<bool> is_settled(graph_.GetVertexCount());
+
+        Queue queue;
+        weights[from] = Weight{};
+        queue.push({Weight{}, from});
+        const auto relax = [&](VertexId vertex, VertexId next_vertex, Weight candidate_weight, std::optional<EdgeId> edge_id) {
+            if (!is_settled[next_vertex] && (!weights[next_vertex] || candidate_weight < *weights[next_vertex])) {
+                weights[next_vertex] = candidate_weight;
+                steps[next_vertex] = OverlayStep{vertex, edge_id};
+                queue.push({candidate_weight, next_vertex});
+            }
+        };
+        size_t settled_count = 0;
+        while (!queue.empty()) {
+            const auto [weight, vertex] = queue.top();
+            queue.pop();
+            if (is_settled[vertex]) {
+                continue;
+            }
+            if (budget.IsExceeded(++settled_count)) {
+                throw SearchBudgetExceeded();
+            }
+            is_settled[vertex] = true;
+            if (vertex == to) {
+                break;
+            }
+            const std::uint32_t cell = vertex_cells_[vertex];
+            const bool is_open_cell = cell == from_cell || cell == to_cell;
+            for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+                const auto& edge = graph_.GetEdge(edge_id);
+                // в закрытых ячейках внутренние рёбра заменены кликой
+                if (is_open_cell || vertex_cells_[edge.to] != cell) {
+                    relax(vertex, edge.to, weight + edge.weight, edge_id);
+                }
+            }
+            if (!is_open_cell && entry_indexes_[vertex] != NOT_ENTRY) {
+                const Cell& overlay_cell = cells_[cell];
+                const size_t exit_count = overlay_cell.exit_vertices.size();
+                const Weight* clique_row = overlay_cell.clique_weights.data() + entry_indexes_[vertex] * exit_count;
+                for (size_t i = 0; i < exit_count; ++i) {
+                    if (clique_row[i] != INFINITE_WEIGHT && overlay_cell.exit_vertices[i] != vertex) {
+                        relax(vertex, overlay_cell.exit_vertices[i], weight + clique_row[i], std::nullopt);
+                    }
+                }
+            }
+        }
+        if (!is_settled[to]) {
+            return std::nullopt;
+        }
+
+        std::vector<std::pair<VertexId, OverlayStep>> path;
+        for (VertexId vertex = to; vertex != from; vertex = steps[vertex]->from) {
+            path.push_back({vertex, *steps[vertex]});
+        }
+        std::vector<EdgeId> edges;
+        for (auto it = path.rbegin(); it != path.rend(); ++it) {
+            if (it->second.edge) {
+                edges.push_back(*it->second.edge);
+            } else {
+                UnpackCliqueEdge(it->second.from, it->first, edges);
+            }
+        }
+        return typename Router<Weight>::RouteInfo{*weights[to], std::move(edges)};
+    }
+
+    template <typename Weight>
+    const std::vector<std::uint32_t>& PartitionOverlay<Weight>::GetVertexCells() const {
+        return vertex_cells_;
+    }
+
+    template <typename Weight>
+    const std::vector<typename PartitionOverlay<Weight>::Cell>& PartitionOverlay<Weight>::GetCells() const {
+        return cells_;
+    }
+
+}  // namespace graph
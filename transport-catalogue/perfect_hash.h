@@ -0,0 +1,198 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+namespace transport_catalogue {
+    namespace detail {
+
+        // Минимальная совершенная хеш-функция неизменного набора различных названий (hash and displace):
+        // название попадает в одну из корзин, а номер корзины задаёт сдвиг (pilot), при котором все названия корзины
+        // получают свободные ячейки. Каждому названию соответствует своя ячейка таблицы из стольких же ячеек, в ней
+        // хранится номер названия. Для названия не из набора Find возвращает номер какого-то другого названия,
+        // поэтому найденное название нужно сравнить с искомым
+        class PerfectNameHash {
+        public:
+            static constexpr std::uint32_t NOT_FOUND = UINT32_MAX;
+
+            PerfectNameHash() = default;
+            // Функция, сохранённая ранее: seed, сдвиги корзин и номера названий по ячейкам
+            PerfectNameHash(std::uint64_t seed, std::vector<std::uint32_t> pilots, std::vector<std::uint32_t> ids);
+
+            // ids[i] — номер названия names[i], названия не должны повторяться
+            void Build(const std::vector<std::string_view>& names, const std::vector<std::uint32_t>& ids);
+
+            // Номер названия, которое может совпадать с name, или NOT_FOUND для пустого набора
+            std::uint32_t Find(std::string_view name) const;
+
+            bool IsEmpty() const;
+            std::uint64_t GetSeed() const;
+            const std::vector<std::uint32_t>& GetPilots() const;
+            const std::vector<std::uint32_t>& GetIds() const;
+
+        private:
+            // в среднем названий на корзину
+            static constexpr size_t BUCKET_SIZE = 4;
+            // при таком количестве неудачных сдвигов одной корзины построение начинается заново с другим seed
+            static constexpr std::uint32_t MAX_PILOT = 1 << 20;
+
+            std::uint64_t seed_ = 0;
+            std::vector<std::uint32_t> pilots_;
+            std::vector<std::uint32_t> ids_;
+
+            static std::uint64_t Mix(std::uint64_t value);
+            static std::uint64_t HashName(std::string_view name, std::uint64_t seed);
+            size_t GetBucket(std::uint64_t hash) const;
+            size_t GetSlot(std::uint64_t hash, std::uint32_t pilot) const;
+            bool TryBuild(const std::vector<std::string_view>& names, const std::vector<std::uint32_t>& ids);
+        };
+
+        inline PerfectNameHash::PerfectNameHash(std::uint64_t seed, std::vector<std::uint32_t> pilots, std::vector<std::uint32_t> ids)
+            : seed_(seed)
+            , pilots_(std::move(pilots))
+            , ids_(std::move(ids)) {
+            if (pilots_.empty() != ids_.empty()) {
+                throw std::invalid_argument("Perfect hash should have both pilots and ids");
+            }
+        }
+
+        inline void PerfectNameHash::Build(const std::vector<std::string_view>& names, const std::vector<std::uint32_t>& ids) {
+            for (seed_ = 0; !TryBuild(names, ids); ++seed_) {
+            }
+        }
+
+        inline std::uint32_t PerfectNameHash::Find(std::string_view name) const {
+            if (ids_.empty()) {
+                return NOT_FOUND;
+            }
+            const std::uint64_t hash = HashName(name, seed_);
+            return ids_[GetSlot(hash, pilots_[GetBucket(hash)])];
+        }
+
+        inline bool PerfectNameHash::IsEmpty() const {
+            return ids_.empty();
+        }
+
+        inline std::uint64_t PerfectNameHash::GetSeed() const {
+            return seed_;
+        }
+
+        inline const std::vector<std::uint32_t>& PerfectNameHash::GetPilots() const {
+            return pilots_;
+        }
+
+        inline const std::vector<std::uint32_t>& PerfectNameHash::GetIds() const {
+            return ids_;
+        }
+
+        inline std::uint64_t PerfectNameHash::Mix(std::uint64_t value) {
+            value ^= value >> 33;
+            value *= 0xff51afd7ed558ccdULL;
+            value ^= value >> 33;
+            value *= 0xc4ceb9fe1a85ec53ULL;
+            value ^= value >> 33;
+            return value;
+        }
+
+        // Хеш не зависит от реализации std::hash, поэтому функция, сохранённая в базе, остаётся верной при чтении
+        inline std::uint64_t PerfectNameHash::HashName(std::string_view name, std::uint64_t seed) {
+            constexpr std::uint64_t MULTIPLIER = 0x9e3779b97f4a7c15ULL;
+            std::uint64_t hash = Mix(seed) ^ (name.size() * MULTIPLIER);
+            size_t i = 0;
+            for (; i + sizeof(std::uint64_t) <= name.size(); i += sizeof(std::uint64_t)) {
+                std::uint64_t word;
+                std::memcpy(&word, name.data() + i, sizeof(word));
+                hash = (hash ^ word) * MULTIPLIER;
+                hash ^= hash >> 29;
+            }
+            if (i < name.size()) {
+                // хвост собирается побайтно: memcpy переменной длины не встраивается компилятором
+                std::uint64_t word = 0;
+                for (size_t shift = 0; i < name.size(); ++i, shift += 8) {
+                    word |= std::uint64_t{static_cast<unsigned char>(name[i])} << shift;
+                }
+                hash = (hash ^ word) * MULTIPLIER;
+            }
+            return Mix(hash);
+        }
+
+        inline size_t PerfectNameHash::GetBucket(std::uint64_t hash) const {
+            return (hash >> 32) * pilots_.size() >> 32;
+        }
+
+        inline size_t PerfectNameHash::GetSlot(std::uint64_t hash, std::uint32_t pilot) const {
+            return static_cast<size_t>((static_cast<unsigned __int128>(Mix(hash ^ Mix(pilot + 1))) * ids_.size()) >> 64);
+        }
+
+        inline bool PerfectNameHash::TryBuild(const std::vector<std::string_view>& names, const std::vector<std::uint32_t>& ids) {
+            const size_t count = names.size();
+            pilots_.assign(count == 0 ? 0 : count / BUCKET_SIZE + 1, 0);
+            ids_.assign(count, NOT_FOUND);
+            if (count == 0) {
+                return true;
+            }
+
+            // названия корзины bucket — keys[bucket_offsets[bucket], bucket_offsets[bucket + 1])
+            std::vector<std::uint64_t> hashes(count);
+            std::vector<std::uint32_t> bucket_offsets(pilots_.size() + 1, 0);
+            for (size_t i = 0; i < count; ++i) {
+                hashes[i] = HashName(names[i], seed_);
+                ++bucket_offsets[GetBucket(hashes[i]) + 1];
+            }
+            std::vector<std::uint32_t> buckets(pilots_.size());
+            for (size_t bucket = 0; bucket < buckets.size(); ++bucket) {
+                buckets[bucket] = static_cast<std::uint32_t>(bucket);
+                bucket_offsets[bucket + 1] += bucket_offsets[bucket];
+            }
+            std::vector<std::uint32_t> keys(count);
+            std::vector<std::uint32_t> positions(bucket_offsets.begin(), bucket_offsets.end() - 1);
+            for (size_t i = 0; i < count; ++i) {
+                keys[positions[GetBucket(hashes[i])]++] = static_cast<std::uint32_t>(i);
+            }
+
+            // большие корзины размещаются первыми, пока свободных ячеек много
+            const auto bucket_size = [&bucket_offsets](std::uint32_t bucket) {
+                return bucket_offsets[bucket + 1] - bucket_offsets[bucket];
+            };
+            std::stable_sort(buckets.begin(), buckets.end(), [&bucket_size](std::uint32_t lhs, std::uint32_t rhs) {
+                return bucket_size(lhs) > bucket_size(rhs);
+            });
+
+            std::vector<bool> is_taken(count);
+            std::vector<size_t> slots;
+            for (const std::uint32_t bucket : buckets) {
+                if (bucket_size(bucket) == 0) {
+                    break;
+                }
+                std::uint32_t pilot = 0;
+                for (;; ++pilot) {
+                    if (pilot == MAX_PILOT) {
+                        return false;
+                    }
+                    slots.clear();
+                    for (std::uint32_t i = bucket_offsets[bucket]; i < bucket_offsets[bucket + 1]; ++i) {
+                        const size_t slot = GetSlot(hashes[keys[i]], pilot);
+                        if (is_taken[slot] || std::find(slots.begin(), slots.end(), slot) != slots.end()) {
+                            break;
+                        }
+                        slots.push_back(slot);
+                    }
+                    if (slots.size() == bucket_size(bucket)) {
+                        break;
+                    }
+                }
+                pilots_[bucket] = pilot;
+                for (size_t i = 0; i < slots.size(); ++i) {
+                    is_taken[slots[i]] = true;
+                    ids_[slots[i]] = ids[keys[bucket_offsets[bucket] + i]];
+                }
+            }
+            return true;
+        }
+
+    } // namespace detail
+} // namespace transport_catalogue
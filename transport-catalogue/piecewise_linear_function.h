@@ -0,0 +1,154 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+    // Периодическая кусочно-линейная функция, заданная точками излома на периоде [0, period).
+    // Между последней точкой и первой точкой следующего периода значения интерполируются так же, как внутри периода.
+    // Точки хранятся в float: профиль по времени суток не требует большей точности
+    class PiecewiseLinearFunction {
+    public:
+        PiecewiseLinearFunction() = default;
+        PiecewiseLinearFunction(std::vector<std::pair<double, double>> points, double period);
+
+        double operator()(double x) const;
+        // Наименьшее y >= x, при котором интеграл функции от x до y равен area. Функция должна быть положительной
+        double SolveIntegral(double x, double area) const;
+
+        bool IsEmpty() const;
+        double GetPeriod() const;
+        std::vector<std::pair<double, double>> GetPoints() const;
+
+    private:
+        // Отрезок интерполяции между соседними точками излома, границы — в периоде, содержащем x
+        struct Segment {
+            size_t prev_index = 0;
+            size_t next_index = 0;
+            double prev_x = 0;
+            double next_x = 0;
+        };
+
+        double period_ = 0;
+        std::vector<float> arguments_;
+        std::vector<float> values_;
+
+        double Normalize(double x) const;
+        // x из [0, period), точек не меньше двух
+        Segment FindSegment(double x) const;
+    };
+
+    inline PiecewiseLinearFunction::PiecewiseLinearFunction(std::vector<std::pair<double, double>> points, double period)
+        : period_(period) {
+        if (period <= 0) {
+            throw std::invalid_argument("Period should be positive");
+        }
+        for (auto& [x, y] : points) {
+            x = std::fmod(x, period);
+            if (x < 0) {
+                x += period;
+            }
+        }
+        std::sort(points.begin(), points.end());
+        for (const auto& [x, y] : points) {
+            if (!arguments_.empty() && arguments_.back() == static_cast<float>(x)) {
+                values_.back() = static_cast<float>(y);
+                continue;
+            }
+            arguments_.push_back(static_cast<float>(x));
+            values_.push_back(static_cast<float>(y));
+        }
+    }
+
+    inline double PiecewiseLinearFunction::operator()(double x) const {
+        if (arguments_.empty()) {
+            throw std::logic_error("Function is empty");
+        }
+        if (arguments_.size() == 1) {
+            return values_.front();
+        }
+        x = Normalize(x);
+        const Segment segment = FindSegment(x);
+        const double ratio = (x - segment.prev_x) / (segment.next_x - segment.prev_x);
+        return values_[segment.prev_index] + (values_[segment.next_index] - values_[segment.prev_index]) * ratio;
+    }
+
+    inline double PiecewiseLinearFunction::SolveIntegral(double x, double area) const {
+        if (arguments_.empty()) {
+            throw std::logic_error("Function is empty");
+        }
+        if (arguments_.size() == 1) {
+            return x + area / values_.front();
+        }
+        double period_area = 0;
+        for (size_t i = 0; i < arguments_.size(); ++i) {
+            const size_t next = (i + 1) % arguments_.size();
+            const double length = next > i ? arguments_[next] - arguments_[i] : arguments_[next] + period_ - arguments_[i];
+            period_area += (values_[i] + values_[next]) / 2 * length;
+        }
+        // целые периоды пропускаются сразу, остаток набирается по отрезкам
+        const double periods = std::floor(area / period_area);
+        double y = x + periods * period_;
+        area -= periods * period_area;
+        double position = Normalize(x);
+        while (true) {
+            const Segment segment = FindSegment(position);
+            const double slope = (values_[segment.next_index] - values_[segment.prev_index]) / (segment.next_x - segment.prev_x);
+            const double value = values_[segment.prev_index] + slope * (position - segment.prev_x);
+            const double length = segment.next_x - position;
+            const double segment_area = (value + slope * length / 2) * length;
+            if (segment_area >= area) {
+                // корень slope / 2 * d^2 + value * d = area в устойчивой форме
+                return y + 2 * area / (value + std::sqrt(std::max(0.0, value * value + 2 * slope * area)));
+            }
+            area -= segment_area;
+            y += length;
+            position = segment.next_x >= period_ ? segment.next_x - period_ : segment.next_x;
+        }
+    }
+
+    inline double PiecewiseLinearFunction::Normalize(double x) const {
+        x = std::fmod(x, period_);
+        if (x < 0) {
+            x += period_;
+        }
+        return x;
+    }
+
+    inline PiecewiseLinearFunction::Segment PiecewiseLinearFunction::FindSegment(double x) const {
+        const size_t last = arguments_.size() - 1;
+        const size_t next = std::upper_bound(arguments_.begin(), arguments_.end(), static_cast<float>(x)) - arguments_.begin();
+        // до первой и после последней точки интерполируется между последней точкой и первой точкой соседнего периода
+        Segment segment{last, 0, arguments_[last], arguments_[0]};
+        if (next == 0) {
+            segment.prev_x -= period_;
+        } else if (next > last) {
+            segment.next_x += period_;
+        } else {
+            segment = {next - 1, next, arguments_[next - 1], arguments_[next]};
+        }
+        return segment;
+    }
+
+    inline bool PiecewiseLinearFunction::IsEmpty() const {
+        return arguments_.empty();
+    }
+
+    inline double PiecewiseLinearFunction::GetPeriod() const {
+        return period_;
+    }
+
+    inline std::vector<std::pair<double, double>> PiecewiseLinearFunction::GetPoints() const {
+        std::vector<std::pair<double, double>> points;
+        points.reserve(arguments_.size());
+        for (size_t i = 0; i < arguments_.size(); ++i) {
+            points.push_back({arguments_[i], values_[i]});
+        }
+        return points;
+    }
+
+}  // namespace graph
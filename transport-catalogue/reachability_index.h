@@ -0,0 +1,258 @@
+#pragma once
+
+#include "graph.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+    // Индекс достижимости: компоненты сильной связности графа и транзитивное замыкание их конденсации.
+    // Отвечает за O(1), существует ли путь между двумя вершинами. Путь есть только внутри слабо связной части
+    // конденсации, поэтому замыкание хранится по частям: битовыми строками, по одной на компоненту части
+    // с битами компонент той же части. Замыкание занимает сумму C_g^2 бит по частям из C_g > 1 компонент,
+    // а остановки без автобусов и другие мелкие части графа не увеличивают строки основной сети
+    class ReachabilityIndex {
+    public:
+        template <typename Weight>
+        explicit ReachabilityIndex(const DirectedWeightedGraph<Weight>& graph);
+        // Индекс, сохранённый ранее. Без частей компонент все компоненты считаются одной частью
+        ReachabilityIndex(std::vector<std::uint32_t>&& components, size_t component_count, std::vector<std::uint32_t>&& component_groups,
+                          std::vector<std::uint64_t>&& reachability);
+
+        bool IsReachable(VertexId from, VertexId to) const;
+
+        const std::vector<std::uint32_t>& GetComponents() const;
+        size_t GetComponentCount() const;
+        const std::vector<std::uint32_t>& GetComponentGroups() const;
+        const std::vector<std::uint64_t>& GetReachability() const;
+
+    private:
+        static constexpr size_t WORD_SIZE = 64;
+
+        std::vector<std::uint32_t> components_;
+        size_t component_count_ = 0;
+        // слабо связная часть конденсации каждой компоненты, части пронумерованы по их первым компонентам
+        std::vector<std::uint32_t> component_groups_;
+        // номер компоненты внутри её части по возрастанию номеров компонент
+        std::vector<std::uint32_t> local_indexes_;
+        // строки части g начинаются со слова group_offsets_[g] и занимают по GetRowWords(g) слов,
+        // у частей из одной компоненты строк нет
+        std::vector<size_t> group_offsets_;
+        std::vector<std::uint32_t> group_sizes_;
+        // строка компоненты c — биты компонент её части, достижимых из c
+        std::vector<std::uint64_t> reachability_;
+
+        size_t GetRowWords(std::uint32_t group) const {
+            return group_sizes_[group] > 1 ? (group_sizes_[group] + WORD_SIZE - 1) / WORD_SIZE : 0;
+        }
+
+        // Номера компонент внутри частей, размеры частей и начала их строк. Возвращает количество слов замыкания
+        size_t IndexGroups() {
+            const size_t group_count = component_groups_.empty() ? 0 : *std::max_element(component_groups_.begin(), component_groups_.end()) + 1;
+            group_sizes_.assign(group_count, 0);
+            local_indexes_.resize(component_count_);
+            for (size_t component = 0; component < component_count_; ++component) {
+                local_indexes_[component] = group_sizes_[component_groups_[component]]++;
+            }
+            group_offsets_.resize(group_count);
+            size_t words_count = 0;
+            for (std::uint32_t group = 0; group < group_count; ++group) {
+                group_offsets_[group] = words_count;
+                words_count += group_sizes_[group] * GetRowWords(group);
+            }
+            return words_count;
+        }
+
+        std::uint64_t* GetRow(std::uint32_t component) {
+            const std::uint32_t group = component_groups_[component];
+            return reachability_.data() + group_offsets_[group] + local_indexes_[component] * GetRowWords(group);
+        }
+
+        // Части — компоненты связности конденсации без учёта направления рёбер
+        template <typename Weight>
+        void ComputeGroups(const DirectedWeightedGraph<Weight>& graph) {
+            std::vector<std::uint32_t> parents(component_count_);
+            for (std::uint32_t component = 0; component < component_count_; ++component) {
+                parents[component] = component;
+            }
+            const auto find_root = [&parents](std::uint32_t component) {
+                while (parents[component] != component) {
+                    component = parents[component] = parents[parents[component]];
+                }
+                return component;
+            };
+            for (const auto& edge : graph.GetEdges()) {
+                const std::uint32_t from_root = find_root(components_[edge.from]);
+                const std::uint32_t to_root = find_root(components_[edge.to]);
+                if (from_root != to_root) {
+                    parents[std::max(from_root, to_root)] = std::min(from_root, to_root);
+                }
+            }
+            constexpr std::uint32_t NO_GROUP = UINT32_MAX;
+            std::vector<std::uint32_t> root_groups(component_count_, NO_GROUP);
+            component_groups_.resize(component_count_);
+            std::uint32_t group_count = 0;
+            for (std::uint32_t component = 0; component < component_count_; ++component) {
+                std::uint32_t& group = root_groups[find_root(component)];
+                if (group == NO_GROUP) {
+                    group = group_count++;
+                }
+                component_groups_[component] = group;
+            }
+        }
+
+        // Нерекурсивный алгоритм Тарьяна. Компоненты нумеруются в порядке завершения,
+        // то есть каждая компонента получает номер позже всех достижимых из неё
+        template <typename Weight>
+        void ComputeComponents(const DirectedWeightedGraph<Weight>& graph) {
+            constexpr std::uint32_t UNVISITED = UINT32_MAX;
+            const size_t vertex_count = graph.GetVertexCount();
+            const auto& incidence_lists = graph.GetIncidenceLists();
+            std::vector<std::uint32_t> indexes(vertex_count, UNVISITED), lowlinks(vertex_count);
+            std::vector<bool> is_on_stack(vertex_count);
+            std::vector<VertexId> stack;
+            std::vector<std::pair<VertexId, size_t>> call_stack;
+            std::uint32_t index = 0;
+            components_.assign(vertex_count, 0);
+
+            const auto visit = [&](VertexId vertex) {
+                indexes[vertex] = lowlinks[vertex] = index++;
+                stack.push_back(vertex);
+                is_on_stack[vertex] = true;
+                call_stack.push_back({vertex, 0});
+            };
+
+            for (VertexId root = 0; root < vertex_count; ++root) {
+                if (indexes[root] != UNVISITED) {
+                    continue;
+                }
+                visit(root);
+                while (!call_stack.empty()) {
+                    auto& [vertex, position] = call_stack.back();
+                    if (position < incidence_lists[vertex].size()) {
+                        const VertexId next_vertex = graph.GetEdge(incidence_lists[vertex][position++]).to;
+                        if (indexes[next_vertex] == UNVISITED) {
+                            visit(next_vertex);
+                        } else if (is_on_stack[next_vertex]) {
+                            lowlinks[vertex] = std::min(lowlinks[vertex], indexes[next_vertex]);
+                        }
+                        continue;
+                    }
+
+                    const VertexId finished_vertex = vertex;
+                    call_stack.pop_back();
+                    if (!call_stack.empty()) {
+                        const VertexId parent = call_stack.back().first;
+                        lowlinks[parent] = std::min(lowlinks[parent], lowlinks[finished_vertex]);
+                    }
+                    if (lowlinks[finished_vertex] == indexes[finished_vertex]) {
+                        VertexId component_vertex;
+                        do {
+                            component_vertex = stack.back();
+                            stack.pop_back();
+                            is_on_stack[component_vertex] = false;
+                            components_[component_vertex] = static_cast<std::uint32_t>(component_count_);
+                        } while (component_vertex != finished_vertex);
+                        ++component_count_;
+                    }
+                }
+            }
+        }
+
+        template <typename Weight>
+        void ComputeReachability(const DirectedWeightedGraph<Weight>& graph) {
+            reachability_.assign(IndexGroups(), 0);
+
+            std::vector<std::vector<VertexId>> component_vertices(component_count_);
+            for (VertexId vertex = 0; vertex < components_.size(); ++vertex) {
+                component_vertices[components_[vertex]].push_back(vertex);
+            }
+
+            std::vector<std::uint32_t> next_components;
+            for (std::uint32_t component = 0; component < component_count_; ++component) {
+                const size_t row_words = GetRowWords(component_groups_[component]);
+                if (row_words == 0) {
+                    continue;
+                }
+                next_components.clear();
+                for (const VertexId vertex : component_vertices[component]) {
+                    for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
+                        const std::uint32_t next_component = components_[graph.GetEdge(edge_id).to];
+                        if (next_component != component) {
+                            next_components.push_back(next_component);
+                        }
+                    }
+                }
+                std::sort(next_components.begin(), next_components.end());
+                next_components.erase(std::unique(next_components.begin(), next_components.end()), next_components.end());
+
+                // следующие компоненты из той же части и получили номера раньше, их строки уже построены
+                std::uint64_t* row = GetRow(component);
+                row[local_indexes_[component] / WORD_SIZE] |= std::uint64_t{1} << (local_indexes_[component] % WORD_SIZE);
+                for (const std::uint32_t next_component : next_components) {
+                    const std::uint64_t* next_row = GetRow(next_component);
+                    for (size_t word = 0; word < row_words; ++word) {
+                        row[word] |= next_row[word];
+                    }
+                }
+            }
+        }
+    };
+
+    template <typename Weight>
+    ReachabilityIndex::ReachabilityIndex(const DirectedWeightedGraph<Weight>& graph) {
+        ComputeComponents(graph);
+        ComputeGroups(graph);
+        ComputeReachability(graph);
+    }
+
+    inline ReachabilityIndex::ReachabilityIndex(std::vector<std::uint32_t>&& components, size_t component_count, std::vector<std::uint32_t>&& component_groups,
+                                                std::vector<std::uint64_t>&& reachability)
+        : components_(std::move(components))
+        , component_count_(component_count)
+        , component_groups_(std::move(component_groups))
+        , reachability_(std::move(reachability)) {
+        if (component_groups_.empty()) {
+            component_groups_.assign(component_count_, 0);
+        }
+        if (component_groups_.size() != component_count_ || IndexGroups() != reachability_.size()) {
+            throw std::invalid_argument("Reachability closure should match the component groups");
+        }
+    }
+
+    inline bool ReachabilityIndex::IsReachable(VertexId from, VertexId to) const {
+        const std::uint32_t from_component = components_.at(from);
+        const std::uint32_t to_component = components_.at(to);
+        if (from_component == to_component) {
+            return true;
+        }
+        const std::uint32_t group = component_groups_[from_component];
+        if (component_groups_[to_component] != group) {
+            return false;
+        }
+        const std::uint32_t to_index = local_indexes_[to_component];
+        const std::uint64_t word = reachability_[group_offsets_[group] + local_indexes_[from_component] * GetRowWords(group) + to_index / WORD_SIZE];
+        return (word >> (to_index % WORD_SIZE)) & 1;
+    }
+
+    inline const std::vector<std::uint32_t>& ReachabilityIndex::GetComponents() const {
+        return components_;
+    }
+
+    inline size_t ReachabilityIndex::GetComponentCount() const {
+        return component_count_;
+    }
+
+    inline const std::vector<std::uint32_t>& ReachabilityIndex::GetComponentGroups() const {
+        return component_groups_;
+    }
+
+    inline const std::vector<std::uint64_t>& ReachabilityIndex::GetReachability() const {
+        return reachability_;
+    }
+
+}  // namespace graph
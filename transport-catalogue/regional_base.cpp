@@ -0,0 +1,440 @@
+#include "regional_base.h"
+#include "serialization.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+
+using namespace std;
+
+namespace transport_catalogue {
+    namespace regional_base {
+
+        string GetRegionFileName(string_view file_name, size_t region) {
+            return string(file_name) + "."s + to_string(region);
+        }
+
+        // Регионы автобуса по возрастанию. Автобус без остановок относится к региону 0
+        vector<uint32_t> GetBusRegions(const domain::Bus& bus, const vector<uint32_t>& stop_regions) {
+            vector<uint32_t> regions;
+            for (const domain::StopId stop : bus.stops) {
+                regions.push_back(stop_regions[stop]);
+            }
+            if (regions.empty()) {
+                regions.push_back(0);
+            }
+            sort(regions.begin(), regions.end());
+            regions.erase(unique(regions.begin(), regions.end()), regions.end());
+            return regions;
+        }
+
+        // База региона из остановок is_region_stop и автобусов region_buses. Номера остановок идут в порядке номеров справочника
+        void BuildRegionCatalogue(TransportCatalogue& region_catalogue, const TransportCatalogue& catalogue, const vector<char>& is_region_stop,
+                                  const vector<domain::BusIndex>& region_buses, const vector<pair<pair<domain::StopId, domain::StopId>, int>>& distances) {
+            constexpr domain::StopId NO_STOP = numeric_limits<domain::StopId>::max();
+            vector<domain::StopId> region_stops(catalogue.GetStopsCount(), NO_STOP);
+            const size_t stops_count = static_cast<size_t>(count(is_region_stop.begin(), is_region_stop.end(), 1));
+            size_t distances_count = 0;
+            for (const auto& [stops, distance] : distances) {
+                distances_count += is_region_stop[stops.first] && is_region_stop[stops.second];
+            }
+
+            CatalogueBuilder builder(region_catalogue, stops_count, distances_count);
+            for (domain::StopId stop = 0; stop < region_stops.size(); ++stop) {
+                if (is_region_stop[stop]) {
+                    region_stops[stop] = builder.AddStop(catalogue.GetStopName(stop), catalogue.GetStopCoordinates(stop));
+                }
+            }
+            for (const domain::BusIndex bus : region_buses) {
+                const domain::Bus& bus_data = catalogue.GetBusByIndex(bus);
+                vector<domain::StopId> stops;
+                stops.reserve(bus_data.stops.size());
+                for (const domain::StopId stop : bus_data.stops) {
+                    stops.push_back(region_stops[stop]);
+                }
+                builder.AddBus(bus_data.name, move(stops), bus_data.is_roundtrip);
+            }
+            for (const auto& [stops, distance] : distances) {
+                if (is_region_stop[stops.first] && is_region_stop[stops.second]) {
+                    builder.SetDistance(region_stops[stops.first], region_stops[stops.second], distance);
+                }
+            }
+            builder.Build();
+            region_catalogue.Freeze();
+        }
+
+        void MakeRegionalBase(const string& file_name, size_t regions_count, const TransportCatalogue& catalogue,
+                              const map_renderer::MapRenderer& renderer, const transport_router::RouterSettings& settings) {
+            if (regions_count == 0) {
+                throw invalid_argument("Regions count should be positive"s);
+            }
+            const size_t stops_count = catalogue.GetStopsCount();
+
+            // регионы — равные отрезки обхода кривой Гильберта, поэтому соседние по карте остановки попадают в один регион
+            vector<uint32_t> stop_regions(stops_count);
+            const vector<domain::StopId> locality_order = transport_router::GetStopsInLocalityOrder(catalogue);
+            for (size_t i = 0; i < stops_count; ++i) {
+                stop_regions[locality_order[i]] = static_cast<uint32_t>(i * regions_count / stops_count);
+            }
+
+            // остановки и автобусы оверлея упорядочены по названиям
+            vector<domain::StopId> stops_by_name(stops_count);
+            for (domain::StopId stop = 0; stop < stops_count; ++stop) {
+                stops_by_name[stop] = stop;
+            }
+            sort(stops_by_name.begin(), stops_by_name.end(), [&catalogue](domain::StopId lhs, domain::StopId rhs) {
+                return catalogue.GetStopName(lhs) < catalogue.GetStopName(rhs);
+            });
+            vector<uint32_t> overlay_stops(stops_count);
+            RegionalOverlay overlay;
+            overlay.regions_count = regions_count;
+            overlay.search_limits = settings.search_limits;
+            for (uint32_t i = 0; i < stops_count; ++i) {
+                overlay_stops[stops_by_name[i]] = i;
+                overlay.stop_names.emplace_back(catalogue.GetStopName(stops_by_name[i]));
+                overlay.stop_regions.push_back(stop_regions[stops_by_name[i]]);
+            }
+
+            // автобусы регионов и граничные остановки: все остановки автобусов из нескольких регионов
+            vector<vector<domain::BusIndex>> region_buses(regions_count);
+            vector<char> is_boundary(stops_count);
+            for (const domain::BusIndex bus : catalogue.GetBusesByName()) {
+                const domain::Bus& bus_data = catalogue.GetBusByIndex(bus);
+                const vector<uint32_t> bus_regions = GetBusRegions(bus_data, stop_regions);
+                for (const uint32_t region : bus_regions) {
+                    region_buses[region].push_back(bus);
+                }
+                if (bus_regions.size() > 1) {
+                    for (const domain::StopId stop : bus_data.stops) {
+                        is_boundary[stop] = true;
+                    }
+                }
+                overlay.bus_names.emplace_back(bus_data.name);
+                overlay.bus_regions.push_back(bus_data.stops.empty() ? 0 : stop_regions[bus_data.stops.front()]);
+            }
+            vector<uint32_t> stop_boundaries(stops_count, numeric_limits<uint32_t>::max());
+            for (uint32_t i = 0; i < stops_count; ++i) {
+                if (is_boundary[stops_by_name[i]]) {
+                    stop_boundaries[stops_by_name[i]] = static_cast<uint32_t>(overlay.boundary_stops.size());
+                    overlay.boundary_stops.push_back(i);
+                }
+            }
+
+            const auto distances = catalogue.GetDistanceBetweenStopsList();
+            // переходы граничных остановок собираются по регионам и раскладываются по порядку граничных остановок
+            vector<vector<pair<uint32_t, double>>> boundary_edges(overlay.boundary_stops.size());
+            overlay.region_boundary_offsets.push_back(0);
+            for (size_t region = 0; region < regions_count; ++region) {
+                vector<char> is_region_stop(stops_count);
+                for (domain::StopId stop = 0; stop < stops_count; ++stop) {
+                    is_region_stop[stop] = stop_regions[stop] == region;
+                }
+                for (const domain::BusIndex bus : region_buses[region]) {
+                    for (const domain::StopId stop : catalogue.GetBusByIndex(bus).stops) {
+                        is_region_stop[stop] = true;
+                    }
+                }
+
+                TransportCatalogue region_catalogue;
+                BuildRegionCatalogue(region_catalogue, catalogue, is_region_stop, region_buses[region], distances);
+                transport_router::RouterSettings region_settings = settings;
+                if (!region_settings.table_file_name.empty()) {
+                    region_settings.table_file_name = GetRegionFileName(settings.table_file_name, region);
+                }
+                transport_router::TransportRouter region_router(region_catalogue, region_settings);
+
+                vector<string_view> boundary_names;
+                vector<uint32_t> region_boundaries;
+                for (const uint32_t stop : overlay.boundary_stops) {
+                    if (is_region_stop[stops_by_name[stop]]) {
+                        region_boundaries.push_back(stop_boundaries[stops_by_name[stop]]);
+                        boundary_names.push_back(overlay.stop_names[stop]);
+                    }
+                }
+                overlay.region_boundary_stops.insert(overlay.region_boundary_stops.end(), region_boundaries.begin(), region_boundaries.end());
+                overlay.region_boundary_offsets.push_back(static_cast<uint32_t>(overlay.region_boundary_stops.size()));
+                for (size_t i = 0; i < region_boundaries.size(); ++i) {
+                    const uint32_t boundary = region_boundaries[i];
+                    if (overlay.stop_regions[overlay.boundary_stops[boundary]] != region) {
+                        continue;
+                    }
+                    const auto routes = region_router.GetRoutesFromStop(boundary_names[i], boundary_names);
+                    for (size_t j = 0; j < routes.size(); ++j) {
+                        if (j != i && routes[j]) {
+                            boundary_edges[boundary].push_back({region_boundaries[j], routes[j]->total_time});
+                        }
+                    }
+                }
+
+                serialization::Serializator serializator;
+                serializator.SetSettings(GetRegionFileName(file_name, region));
+                serializator.SerializeData(region_catalogue, renderer, region_router);
+            }
+
+            overlay.edge_offsets.push_back(0);
+            for (const auto& edges : boundary_edges) {
+                for (const auto& [target, time] : edges) {
+                    overlay.edge_targets.push_back(target);
+                    overlay.edge_times.push_back(time);
+                }
+                overlay.edge_offsets.push_back(static_cast<uint32_t>(overlay.edge_targets.size()));
+            }
+
+            serialization::Serializator serializator;
+            serializator.SetSettings(string(file_name));
+            serializator.SerializeRegionalOverlay(overlay);
+        }
+
+        RegionalCatalogue::RegionalCatalogue(const string& file_name)
+            : file_name_(file_name) {
+            serialization::Serializator serializator;
+            serializator.SetSettings(string(file_name));
+            overlay_ = serializator.DeserializeRegionalOverlay();
+            regions_.resize(overlay_.regions_count);
+
+            vector<string_view> stop_names(overlay_.stop_names.begin(), overlay_.stop_names.end());
+            vector<uint32_t> stop_ids(stop_names.size());
+            for (uint32_t stop = 0; stop < stop_ids.size(); ++stop) {
+                stop_ids[stop] = stop;
+            }
+            stop_name_trie_.Build(stop_names, stop_ids);
+            stop_boundaries_.assign(overlay_.stop_names.size(), NO_BOUNDARY);
+            for (uint32_t boundary = 0; boundary < overlay_.boundary_stops.size(); ++boundary) {
+                stop_boundaries_[overlay_.boundary_stops[boundary]] = boundary;
+            }
+        }
+
+        optional<domain::RouteInfo> RegionalCatalogue::GetRouteInfo(string_view bus_name) const {
+            const auto bus = FindBus(bus_name);
+            if (!bus) {
+                return nullopt;
+            }
+            const TransportCatalogue& catalogue = GetRegion(overlay_.bus_regions[*bus]).catalogue;
+            return catalogue.GetRouteInfo(catalogue.GetBus(bus_name));
+        }
+
+        optional<vector<string>> RegionalCatalogue::GetBusesForStop(string_view stop_name) const {
+            const auto stop = FindStop(stop_name);
+            if (!stop) {
+                return nullopt;
+            }
+            // база региона остановки содержит все автобусы через неё
+            const TransportCatalogue& catalogue = GetRegion(overlay_.stop_regions[*stop]).catalogue;
+            vector<string> buses;
+            for (const domain::BusIndex bus : catalogue.GetBusesForStop(*catalogue.GetStop(stop_name))) {
+                buses.emplace_back(catalogue.GetBusByIndex(bus).name);
+            }
+            return buses;
+        }
+
+        optional<vector<string>> RegionalCatalogue::GetDirectBuses(string_view stop_from_name, string_view stop_to_name) const {
+            const auto stop_from = FindStop(stop_from_name);
+            if (!stop_from || !FindStop(stop_to_name)) {
+                return nullopt;
+            }
+            // автобусы через обе остановки есть в базе региона from, в которой нет to, если таких автобусов нет
+            const TransportCatalogue& catalogue = GetRegion(overlay_.stop_regions[*stop_from]).catalogue;
+            vector<string> buses;
+            if (const auto stop_to = catalogue.GetStop(stop_to_name)) {
+                for (const domain::BusIndex bus : catalogue.GetDirectBuses(*catalogue.GetStop(stop_from_name), *stop_to)) {
+                    buses.emplace_back(catalogue.GetBusByIndex(bus).name);
+                }
+            }
+            return buses;
+        }
+
+        vector<string> RegionalCatalogue::FindStopsByPrefix(string_view prefix, size_t limit) const {
+            return GetStopNames(stop_name_trie_.FindByPrefix(prefix, limit));
+        }
+
+        vector<string> RegionalCatalogue::FindSimilarStops(string_view stop_name, size_t max_distance, size_t limit) const {
+            return GetStopNames(stop_name_trie_.FindSimilar(stop_name, max_distance, limit));
+        }
+
+        // Кратчайший маршрут разбивается на поездки, и каждая поездка есть в базе региона своей начальной остановки.
+        // Поездки, начальные остановки которых сменили регион, начинаются в граничных остановках, поэтому
+        // маршрут до последней граничной остановки, после которой все поездки заканчиваются в регионе to, — это маршрут
+        // по базе региона from до граничной остановки и переходы оверлея. Оставшаяся часть проходит по базе региона to.
+        // Маршруты без таких граничных остановок целиком проходят по базе региона from или региона to
+        optional<transport_router::TransportRouter::RouteItems> RegionalCatalogue::GetRouteByStops(string_view stop_from_name, string_view stop_to_name,
+                                                                                                   const transport_router::SearchLimits& limits) const {
+            using RouteItems = transport_router::TransportRouter::RouteItems;
+            const auto stop_from = FindStop(stop_from_name);
+            const auto stop_to = FindStop(stop_to_name);
+            if (!stop_from || !stop_to) {
+                return nullopt;
+            }
+            const uint32_t region_from = overlay_.stop_regions[*stop_from];
+            const uint32_t region_to = overlay_.stop_regions[*stop_to];
+            const Region& from = GetRegion(region_from);
+            const Region& to = GetRegion(region_to);
+
+            optional<RouteItems> best_route = from.router.GetRouteByStops(stop_from_name, stop_to_name, limits);
+            if (region_to != region_from) {
+                auto route = to.router.GetRouteByStops(stop_from_name, stop_to_name, limits);
+                if (route && (!best_route || route->total_time < best_route->total_time)) {
+                    best_route = move(route);
+                }
+            }
+
+            // начальные отрезки до граничных остановок базы региона from
+            const uint32_t* from_boundaries = overlay_.region_boundary_stops.data() + overlay_.region_boundary_offsets[region_from];
+            const size_t from_boundaries_count = overlay_.region_boundary_offsets[region_from + 1] - overlay_.region_boundary_offsets[region_from];
+            vector<string_view> boundary_names;
+            boundary_names.reserve(from_boundaries_count);
+            for (size_t i = 0; i < from_boundaries_count; ++i) {
+                boundary_names.push_back(overlay_.stop_names[overlay_.boundary_stops[from_boundaries[i]]]);
+            }
+            const size_t boundaries_count = overlay_.boundary_stops.size();
+            vector<double> times(boundaries_count, numeric_limits<double>::infinity());
+            vector<uint32_t> previous(boundaries_count, NO_BOUNDARY);
+            vector<optional<RouteItems>> first_legs = from.router.GetRoutesFromStop(stop_from_name, boundary_names);
+            using QueueItem = pair<double, uint32_t>;
+            priority_queue<QueueItem, vector<QueueItem>, greater<QueueItem>> queue;
+            for (size_t i = 0; i < from_boundaries_count; ++i) {
+                if (first_legs[i] && first_legs[i]->total_time < times[from_boundaries[i]]) {
+                    times[from_boundaries[i]] = first_legs[i]->total_time;
+                    queue.push({first_legs[i]->total_time, from_boundaries[i]});
+                }
+            }
+
+            // поиск Дейкстры по переходам оверлея
+            while (!queue.empty()) {
+                const auto [time, boundary] = queue.top();
+                queue.pop();
+                if (time > times[boundary]) {
+                    continue;
+                }
+                for (uint32_t edge = overlay_.edge_offsets[boundary]; edge < overlay_.edge_offsets[boundary + 1]; ++edge) {
+                    const uint32_t target = overlay_.edge_targets[edge];
+                    const double target_time = time + overlay_.edge_times[edge];
+                    if (target_time < times[target]) {
+                        times[target] = target_time;
+                        previous[target] = boundary;
+                        queue.push({target_time, target});
+                    }
+                }
+            }
+
+            // конечные отрезки от граничных остановок базы региона to, начиная с ближайших
+            vector<uint32_t> to_boundaries;
+            for (uint32_t i = overlay_.region_boundary_offsets[region_to]; i < overlay_.region_boundary_offsets[region_to + 1]; ++i) {
+                if (times[overlay_.region_boundary_stops[i]] < numeric_limits<double>::infinity()) {
+                    to_boundaries.push_back(overlay_.region_boundary_stops[i]);
+                }
+            }
+            sort(to_boundaries.begin(), to_boundaries.end(), [&times](uint32_t lhs, uint32_t rhs) {
+                return times[lhs] < times[rhs];
+            });
+            uint32_t best_boundary = NO_BOUNDARY;
+            optional<RouteItems> last_leg;
+            for (const uint32_t boundary : to_boundaries) {
+                if (best_route && times[boundary] >= best_route->total_time) {
+                    break;
+                }
+                auto leg = to.router.GetRouteByStops(overlay_.stop_names[overlay_.boundary_stops[boundary]], stop_to_name, limits);
+                if (leg && (!best_route || times[boundary] + leg->total_time < best_route->total_time)) {
+                    best_route = RouteItems{times[boundary] + leg->total_time, {}};
+                    best_boundary = boundary;
+                    last_leg = move(leg);
+                }
+            }
+            if (best_boundary == NO_BOUNDARY) {
+                return best_route;
+            }
+
+            // переходы выбранного маршрута разворачиваются по базам регионов их начальных остановок
+            vector<uint32_t> path{best_boundary};
+            while (previous[path.back()] != NO_BOUNDARY) {
+                path.push_back(previous[path.back()]);
+            }
+            reverse(path.begin(), path.end());
+            vector<optional<RouteItems>> legs;
+            for (size_t i = 0; i < from_boundaries_count; ++i) {
+                if (from_boundaries[i] == path.front()) {
+                    legs.push_back(move(first_legs[i]));
+                    break;
+                }
+            }
+            for (size_t i = 0; i + 1 < path.size(); ++i) {
+                const uint32_t stop = overlay_.boundary_stops[path[i]];
+                legs.push_back(GetRegion(overlay_.stop_regions[stop]).router.GetRouteByStops(overlay_.stop_names[stop],
+                                                                                            overlay_.stop_names[overlay_.boundary_stops[path[i + 1]]], limits));
+            }
+            legs.push_back(move(last_leg));
+            return transport_router::TransportRouter::JoinRoutes(move(legs));
+        }
+
+        optional<transport_router::TransportRouter::RouteItems> RegionalCatalogue::GetRouteViaStops(string_view stop_from_name, const vector<string_view>& via_stop_names,
+                                                                                                    string_view stop_to_name, const transport_router::SearchLimits& limits) const {
+            vector<string_view> stop_names{stop_from_name};
+            stop_names.insert(stop_names.end(), via_stop_names.begin(), via_stop_names.end());
+            stop_names.push_back(stop_to_name);
+            vector<optional<transport_router::TransportRouter::RouteItems>> legs;
+            for (size_t i = 0; i + 1 < stop_names.size(); ++i) {
+                legs.push_back(GetRouteByStops(stop_names[i], stop_names[i + 1], limits));
+                if (!legs.back()) {
+                    return nullopt;
+                }
+            }
+            return transport_router::TransportRouter::JoinRoutes(move(legs));
+        }
+
+        const transport_router::SearchLimits& RegionalCatalogue::GetSearchLimits() const {
+            return overlay_.search_limits;
+        }
+
+        size_t RegionalCatalogue::GetRegionsCount() const {
+            return overlay_.regions_count;
+        }
+
+        size_t RegionalCatalogue::GetLoadedRegionsCount() const {
+            lock_guard guard(mutex_);
+            return static_cast<size_t>(count_if(regions_.begin(), regions_.end(), [](const auto& region) {
+                return region != nullptr;
+            }));
+        }
+
+        // База читается под блокировкой, прочитанная база только читается и не перемещается
+        const RegionalCatalogue::Region& RegionalCatalogue::GetRegion(size_t region) const {
+            lock_guard guard(mutex_);
+            if (!regions_[region]) {
+                auto loaded = make_unique<Region>();
+                serialization::Serializator serializator;
+                serializator.SetSettings(GetRegionFileName(file_name_, region));
+                serializator.DeserializeFile(loaded->catalogue, loaded->renderer, loaded->router);
+                regions_[region] = move(loaded);
+            }
+            return *regions_[region];
+        }
+
+        optional<uint32_t> RegionalCatalogue::FindStop(string_view stop_name) const {
+            const auto it = lower_bound(overlay_.stop_names.begin(), overlay_.stop_names.end(), stop_name);
+            if (it == overlay_.stop_names.end() || *it != stop_name) {
+                return nullopt;
+            }
+            return static_cast<uint32_t>(it - overlay_.stop_names.begin());
+        }
+
+        optional<uint32_t> RegionalCatalogue::FindBus(string_view bus_name) const {
+            const auto it = lower_bound(overlay_.bus_names.begin(), overlay_.bus_names.end(), bus_name);
+            if (it == overlay_.bus_names.end() || *it != bus_name) {
+                return nullopt;
+            }
+            return static_cast<uint32_t>(it - overlay_.bus_names.begin());
+        }
+
+        vector<string> RegionalCatalogue::GetStopNames(const vector<uint32_t>& stops) const {
+            vector<string> stop_names;
+            stop_names.reserve(stops.size());
+            for (const uint32_t stop : stops) {
+                stop_names.push_back(overlay_.stop_names[stop]);
+            }
+            return stop_names;
+        }
+
+    } // namespace regional_base
+} // namespace transport_catalogue
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "domain.h"
+#include "map_renderer.h"
+#include "name_trie.h"
+#include "transport_catalogue.h"
+#include "transport_router.h"
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace transport_catalogue {
+    namespace regional_base {
+
+        // Оверлей базы, разделённой на регионы. Граничная остановка — остановка автобуса, который проходит
+        // через несколько регионов. Переход p → q — время кратчайшего маршрута от граничной остановки p
+        // до граничной остановки q по базе региона p. Граничные остановки и переходы задаются номерами в boundary_stops
+        struct RegionalOverlay {
+            size_t regions_count = 0;
+            // остановки в порядке названий и их регионы
+            std::vector<std::string> stop_names;
+            std::vector<std::uint32_t> stop_regions;
+            // автобусы в порядке названий и регионы, базы которых отвечают на запросы автобусов
+            std::vector<std::string> bus_names;
+            std::vector<std::uint32_t> bus_regions;
+            // номера граничных остановок в stop_names по возрастанию
+            std::vector<std::uint32_t> boundary_stops;
+            // граничные остановки из базы региона r — region_boundary_stops[region_boundary_offsets[r], region_boundary_offsets[r + 1])
+            std::vector<std::uint32_t> region_boundary_offsets;
+            std::vector<std::uint32_t> region_boundary_stops;
+            // переходы из граничной остановки b — edge_targets и edge_times [edge_offsets[b], edge_offsets[b + 1])
+            std::vector<std::uint32_t> edge_offsets;
+            std::vector<std::uint32_t> edge_targets;
+            std::vector<double> edge_times;
+            // ограничения поиска из настроек маршрутизатора баз регионов
+            transport_router::SearchLimits search_limits;
+        };
+
+        // Файл базы региона: file_name с номером региона через точку
+        std::string GetRegionFileName(std::string_view file_name, size_t region);
+
+        // Делит остановки на regions_count регионов равными отрезками обхода кривой Гильберта, записывает базы
+        // регионов в GetRegionFileName(file_name, region) и оверлей в file_name. База региона — обычная база
+        // из остановок региона, всех автобусов через них целиком с остальными их остановками, расстояний
+        // между этими остановками и маршрутизатора с настройками settings. Файл таблицы в режиме PAGED_TABLE
+        // у каждого региона свой, с номером региона через точку
+        void MakeRegionalBase(const std::string& file_name, size_t regions_count, const TransportCatalogue& catalogue,
+                              const map_renderer::MapRenderer& renderer, const transport_router::RouterSettings& settings);
+
+        // Справочник, разделённый на базы регионов. При создании читается только оверлей, базы регионов
+        // читаются при первом обращении к ним. Маршрут между регионами складывается из маршрута по базе
+        // начального региона до граничной остановки, переходов оверлея и маршрута по базе конечного региона
+        // от граничной остановки, поэтому он совпадает с кратчайшим маршрутом по неразделённой базе,
+        // а читаются только базы начального и конечного регионов и регионов переходов выбранного маршрута.
+        // Методы можно вызывать из нескольких потоков
+        class RegionalCatalogue {
+        public:
+            explicit RegionalCatalogue(const std::string& file_name);
+
+            // std::nullopt — автобуса или остановки нет
+            std::optional<domain::RouteInfo> GetRouteInfo(std::string_view bus_name) const;
+            // Автобусы остановки в порядке названий
+            std::optional<std::vector<std::string>> GetBusesForStop(std::string_view stop_name) const;
+            // Автобусы от from до to без пересадок в порядке названий
+            std::optional<std::vector<std::string>> GetDirectBuses(std::string_view stop_from_name, std::string_view stop_to_name) const;
+            // Поиск остановок по названиям, как в TransportCatalogue
+            std::vector<std::string> FindStopsByPrefix(std::string_view prefix, size_t limit) const;
+            std::vector<std::string> FindSimilarStops(std::string_view stop_name, size_t max_distance, size_t limit) const;
+
+            // Ограничения действуют на поиски отрезков по базам регионов, общий поиск от from до граничных остановок
+            // ограничен настройками баз
+            std::optional<transport_router::TransportRouter::RouteItems> GetRouteByStops(std::string_view stop_from_name, std::string_view stop_to_name,
+                                                                                         const transport_router::SearchLimits& limits) const;
+            std::optional<transport_router::TransportRouter::RouteItems> GetRouteViaStops(std::string_view stop_from_name, const std::vector<std::string_view>& via_stop_names,
+                                                                                          std::string_view stop_to_name, const transport_router::SearchLimits& limits) const;
+            // Ограничения поиска из routing_settings, с которыми построены базы регионов
+            const transport_router::SearchLimits& GetSearchLimits() const;
+
+            size_t GetRegionsCount() const;
+            size_t GetLoadedRegionsCount() const;
+
+        private:
+            static constexpr std::uint32_t NO_BOUNDARY = UINT32_MAX;
+
+            struct Region {
+                TransportCatalogue catalogue;
+                map_renderer::MapRenderer renderer;
+                transport_router::TransportRouter router{catalogue};
+            };
+
+            std::string file_name_;
+            RegionalOverlay overlay_;
+            detail::NameTrie stop_name_trie_;
+            // номер граничной остановки по номеру остановки или NO_BOUNDARY
+            std::vector<std::uint32_t> stop_boundaries_;
+
+            mutable std::mutex mutex_;
+            mutable std::vector<std::unique_ptr<const Region>> regions_;
+
+            const Region& GetRegion(size_t region) const;
+            std::optional<std::uint32_t> FindStop(std::string_view stop_name) const;
+            std::optional<std::uint32_t> FindBus(std::string_view bus_name) const;
+            std::vector<std::string> GetStopNames(const std::vector<std::uint32_t>& stops) const;
+        };
+
+    } // namespace regional_base
+} // namespace transport_catalogue
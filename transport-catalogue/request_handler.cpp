@@ -8,7 +8,7 @@ namespace transport_catalogue {
         RequestHandler::RequestHandler(const TransportCatalogue& catalogue, const map_renderer::MapRenderer& renderer) : catalogue_(catalogue), renderer_(renderer) {}
 
         svg::Document RequestHandler::RenderMap() const {
-            return renderer_.RenderMap(catalogue_.GetBusesList());
+            return renderer_.RenderMap(catalogue_);
         }
         
     } // namespace request_handler
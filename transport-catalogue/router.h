@@ -6,7 +6,9 @@
 #include <cassert>
 #include <cstdint>
 #include <iterator>
+#include <functional>
 #include <optional>
+#include <queue>
 #include <stdexcept>
 #include <unordered_map>
 #include <utility>
@@ -38,6 +40,11 @@ namespace graph {
 
         std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
 
+        // Восстанавливает таблицу маршрутов после изменения веса ребра edge_id в графе или его удаления из графа.
+        // Пересчитываются только пары, кратчайший путь которых проходил через это ребро (при увеличении веса)
+        // или может через него пройти (при уменьшении). Возвращает количество обновлённых пар
+        size_t UpdateEdge(EdgeId edge_id, Weight old_weight);
+
         const RoutesInternalData& GetRoutesInternalData() const;
 
     private:
@@ -82,7 +89,148 @@ namespace graph {
                     }
                 }
             }
-        }     
+        }
+
+        // Вес ребра уменьшился: кратчайшие пути могут только сократиться, причём через это ребро
+        size_t RelaxRoutesThroughEdge(EdgeId edge_id) {
+            const auto& edge = graph_.GetEdge(edge_id);
+            const size_t vertex_count = graph_.GetVertexCount();
+            size_t updated_routes = 0;
+            for (VertexId vertex_from = 0; vertex_from < vertex_count; ++vertex_from) {
+                if (vertex_from == edge.to || !routes_internal_data_[vertex_from][edge.from]) {
+                    continue;
+                }
+                const Weight weight_to_edge = routes_internal_data_[vertex_from][edge.from]->weight + edge.weight;
+                for (VertexId vertex_to = 0; vertex_to < vertex_count; ++vertex_to) {
+                    const auto& route_from_edge = routes_internal_data_[edge.to][vertex_to];
+                    if (!route_from_edge) {
+                        continue;
+                    }
+                    auto& route_relaxing = routes_internal_data_[vertex_from][vertex_to];
+                    const Weight candidate_weight = weight_to_edge + route_from_edge->weight;
+                    if (!route_relaxing || candidate_weight < route_relaxing->weight) {
+                        route_relaxing = {candidate_weight,
+                                          route_from_edge->prev_edge ? route_from_edge->prev_edge : edge_id};
+                        ++updated_routes;
+                    }
+                }
+            }
+            return updated_routes;
+        }
+
+        // Вес ребра увеличился или ребро удалено: пересчитываются только поддеревья кратчайших путей,
+        // висящие на этом ребре. Для каждой затронутой строки таблицы запускается Дейкстра по затронутым вершинам,
+        // начальные оценки которых берутся из рёбер, входящих в них из незатронутой части дерева
+        size_t RepairRoutesUsingEdge(EdgeId edge_id) {
+            enum class VertexState : char { UNKNOWN, AFFECTED, INTACT };
+            using QueueItem = std::pair<Weight, VertexId>;
+
+            const auto& edge = graph_.GetEdge(edge_id);
+            const size_t vertex_count = graph_.GetVertexCount();
+
+            std::vector<IncidenceList> incoming_edges(vertex_count);
+            for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+                for (const EdgeId incident_edge_id : graph_.GetIncidentEdges(vertex)) {
+                    incoming_edges[graph_.GetEdge(incident_edge_id).to].push_back(incident_edge_id);
+                }
+            }
+
+            size_t updated_routes = 0;
+            std::vector<VertexState> states(vertex_count);
+            std::vector<VertexId> affected_vertices, path;
+            std::vector<std::optional<RouteInternalData<Weight>>> old_routes;
+            for (VertexId vertex_from = 0; vertex_from < vertex_count; ++vertex_from) {
+                auto& routes_from = routes_internal_data_[vertex_from];
+                if (!routes_from[edge.to] || routes_from[edge.to]->prev_edge != edge_id) {
+                    continue;
+                }
+
+                // помечаем вершины, путь до которых проходит через ребро
+                std::fill(states.begin(), states.end(), VertexState::UNKNOWN);
+                affected_vertices.clear();
+                for (VertexId vertex_to = 0; vertex_to < vertex_count; ++vertex_to) {
+                    path.clear();
+                    VertexState state = VertexState::INTACT;
+                    for (VertexId vertex = vertex_to; ; ) {
+                        if (states[vertex] != VertexState::UNKNOWN) {
+                            state = states[vertex];
+                            break;
+                        }
+                        path.push_back(vertex);
+                        const auto& route = routes_from[vertex];
+                        if (!route || !route->prev_edge) {
+                            break;
+                        }
+                        if (*route->prev_edge == edge_id) {
+                            state = VertexState::AFFECTED;
+                            break;
+                        }
+                        vertex = graph_.GetEdge(*route->prev_edge).from;
+                    }
+                    for (const VertexId vertex : path) {
+                        states[vertex] = state;
+                        if (state == VertexState::AFFECTED) {
+                            affected_vertices.push_back(vertex);
+                        }
+                    }
+                }
+
+                old_routes.clear();
+                for (const VertexId vertex : affected_vertices) {
+                    old_routes.push_back(routes_from[vertex]);
+                    routes_from[vertex].reset();
+                }
+
+                std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+                for (const VertexId vertex : affected_vertices) {
+                    auto& route = routes_from[vertex];
+                    for (const EdgeId incoming_edge_id : incoming_edges[vertex]) {
+                        const auto& incoming_edge = graph_.GetEdge(incoming_edge_id);
+                        const auto& route_before = routes_from[incoming_edge.from];
+                        if (states[incoming_edge.from] == VertexState::AFFECTED || !route_before) {
+                            continue;
+                        }
+                        const Weight candidate_weight = route_before->weight + incoming_edge.weight;
+                        if (!route || candidate_weight < route->weight) {
+                            route = RouteInternalData<Weight>{candidate_weight, incoming_edge_id};
+                        }
+                    }
+                    if (route) {
+                        queue.push({route->weight, vertex});
+                    }
+                }
+
+                while (!queue.empty()) {
+                    const auto [weight, vertex] = queue.top();
+                    queue.pop();
+                    if (routes_from[vertex]->weight < weight) {
+                        continue;
+                    }
+                    for (const EdgeId outgoing_edge_id : graph_.GetIncidentEdges(vertex)) {
+                        const auto& outgoing_edge = graph_.GetEdge(outgoing_edge_id);
+                        if (states[outgoing_edge.to] != VertexState::AFFECTED) {
+                            continue;
+                        }
+                        auto& route = routes_from[outgoing_edge.to];
+                        const Weight candidate_weight = weight + outgoing_edge.weight;
+                        if (!route || candidate_weight < route->weight) {
+                            route = RouteInternalData<Weight>{candidate_weight, outgoing_edge_id};
+                            queue.push({candidate_weight, outgoing_edge.to});
+                        }
+                    }
+                }
+
+                for (size_t i = 0; i < affected_vertices.size(); ++i) {
+                    const auto& old_route = old_routes[i];
+                    const auto& new_route = routes_from[affected_vertices[i]];
+                    if (!old_route || !new_route || old_route->weight != new_route->weight
+                        || old_route->prev_edge != new_route->prev_edge) {
+                        ++updated_routes;
+                    }
+                }
+            }
+            return updated_routes;
+        }
     };
 
     template <typename Weight>
@@ -123,6 +271,23 @@ namespace graph {
         return RouteInfo{weight, std::move(edges)};
     }
 
+    template <typename Weight>
+    size_t Router<Weight>::UpdateEdge(EdgeId edge_id, Weight old_weight) {
+        const auto& edge = graph_.GetEdge(edge_id);
+        if (edge.weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+        const auto incident_edges = graph_.GetIncidentEdges(edge.from);
+        const bool is_attached = std::find(incident_edges.begin(), incident_edges.end(), edge_id) != incident_edges.end();
+        if (is_attached && edge.weight < old_weight) {
+            return RelaxRoutesThroughEdge(edge_id);
+        }
+        if (!is_attached || old_weight < edge.weight) {
+            return RepairRoutesUsingEdge(edge_id);
+        }
+        return 0;
+    }
+
     template<typename Weight>
     const RoutesInternalData& Router<Weight>::GetRoutesInternalData() const{
         return routes_internal_data_;
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <chrono>
+#include <optional>
+#include <stdexcept>
+
+namespace graph {
+
+    // Ограничение поиска по графу: количество окончательно обработанных вершин и/или крайний срок.
+    // Поиск проверяет его после обработки каждой вершины и прерывается, когда ограничение исчерпано
+    class SearchBudget {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        SearchBudget() = default;
+        // 0 в settle_limit — без ограничения количества вершин, крайний срок отсчитывается от момента создания
+        SearchBudget(size_t settle_limit, std::optional<Clock::duration> time_limit);
+
+        bool IsExceeded(size_t settled_count) const;
+
+    private:
+        // часы опрашиваются не после каждой вершины, а раз в CLOCK_CHECK_PERIOD вершин
+        static constexpr size_t CLOCK_CHECK_PERIOD = 64;
+
+        size_t settle_limit_ = 0;
+        std::optional<Clock::time_point> deadline_;
+    };
+
+    // Ответ не получен, потому что поиск исчерпал SearchBudget
+    class SearchBudgetExceeded : public std::runtime_error {
+    public:
+        SearchBudgetExceeded()
+            : std::runtime_error("Search budget is exceeded") {}
+    };
+
+    inline SearchBudget::SearchBudget(size_t settle_limit, std::optional<Clock::duration> time_limit)
+        : settle_limit_(settle_limit) {
+        if (time_limit) {
+            deadline_ = Clock::now() + *time_limit;
+        }
+    }
+
+    inline bool SearchBudget::IsExceeded(size_t settled_count) const {
+        if (settle_limit_ > 0 && settled_count > settle_limit_) {
+            return true;
+        }
+        return deadline_ && settled_count % CLOCK_CHECK_PERIOD == 0 && Clock::now() > *deadline_;
+    }
+
+}  // namespace graph
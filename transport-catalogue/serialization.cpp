@@ -2,7 +2,6 @@
 #include "domain.h"
 
 #include <algorithm>
-#include <deque>
 #include <fstream>
 #include <iterator>
 #include <map>
@@ -18,24 +17,50 @@ using namespace std;
 namespace transport_catalogue {
     namespace serialization {
 
+		transport_catalogue_proto::PerfectNameHash GetPerfectNameHashData(const detail::PerfectNameHash& name_hash) {
+			transport_catalogue_proto::PerfectNameHash name_hash_proto;
+			// filling name_hash_proto
+			{
+				name_hash_proto.set_seed(name_hash.GetSeed());
+				name_hash_proto.mutable_pilots()->Add(name_hash.GetPilots().begin(), name_hash.GetPilots().end());
+				name_hash_proto.mutable_ids()->Add(name_hash.GetIds().begin(), name_hash.GetIds().end());
+			}
+
+			return name_hash_proto;
+		}
+
+		transport_catalogue_proto::NameTrie GetNameTrieData(const detail::NameTrie& name_trie) {
+			transport_catalogue_proto::NameTrie name_trie_proto;
+			// filling name_trie_proto
+			{
+				name_trie_proto.mutable_child_offsets()->Add(name_trie.GetChildOffsets().begin(), name_trie.GetChildOffsets().end());
+				name_trie_proto.set_labels(name_trie.GetLabels());
+				name_trie_proto.mutable_stops()->Add(name_trie.GetIds().begin(), name_trie.GetIds().end());
+			}
+
+			return name_trie_proto;
+		}
+
 		transport_catalogue_proto::CatalogueData Serializator::GetCatalogueDataForSerialization(const transport_catalogue::TransportCatalogue& catalogue) {
 			transport_catalogue_proto::CatalogueData catalogue_data;
 			
-			const auto& stops_list = catalogue.GetAllStops();
+			const size_t stops_count = catalogue.GetStopsCount();
 			size_t id = 0;
-			for (const domain::Stop& stop : stops_list) {
+			for (domain::StopId stop = 0; stop < stops_count; ++stop) {
+				const string stop_name(catalogue.GetStopName(stop));
+				const geo::Coordinates coordinates = catalogue.GetStopCoordinates(stop);
 				transport_catalogue_proto::Stop stop_proto;
 				// filling stop_proto
 				{
 					stop_proto.set_id(id);
-					stop_proto.set_name(stop.name);
-					stop_proto.set_latitude(stop.coordinates.lat);
-					stop_proto.set_longitude(stop.coordinates.lng);
+					stop_proto.set_name(stop_name);
+					stop_proto.set_latitude(coordinates.lat);
+					stop_proto.set_longitude(coordinates.lng);
 				}
 
 				*catalogue_data.add_stops() = move(stop_proto);
 
-				stop_name_to_stop_id_[stop.name] = id;
+				stop_name_to_stop_id_[stop_name] = id;
 				++id;
 			}
 
@@ -46,10 +71,10 @@ namespace transport_catalogue {
 				// filling bus_proto
 				{
 					bus_proto.set_id(id);
-					bus_proto.set_name(bus.name);
+					bus_proto.set_name(string(bus.name));
 
-					for (const domain::Stop* stop : bus.stops) {
-						bus_proto.add_stops(stop_name_to_stop_id_[stop->name]);
+					for (const domain::StopId stop : bus.stops) {
+						bus_proto.add_stops(stop);
 					}
 
 					bus_proto.set_is_roundtrip(bus.is_roundtrip);
@@ -57,7 +82,7 @@ namespace transport_catalogue {
 
 				*catalogue_data.add_buses() = move(bus_proto);
 
-				bus_name_to_bus_id_[bus.name] = id;
+				bus_name_to_bus_id_[string(bus.name)] = id;
 				++id;
 			}
 
@@ -66,14 +91,22 @@ namespace transport_catalogue {
 				transport_catalogue_proto::Distance distance_proto;
 				// filling distance_proto
 				{
-					distance_proto.set_stop_from(stop_name_to_stop_id_[stops_pair.first->name]);
-					distance_proto.set_stop_to(stop_name_to_stop_id_[stops_pair.second->name]);
+					distance_proto.set_stop_from(stops_pair.first);
+					distance_proto.set_stop_to(stops_pair.second);
 					distance_proto.set_distance(distance);
 				}
 
 				*catalogue_data.add_distance_between_stops() = move(distance_proto);
 			}
 
+			// номера остановок и автобусов в базе совпадают с их номерами в справочнике
+			const StopBuses& stop_buses = catalogue.GetStopBuses();
+			catalogue_data.mutable_stop_bus_offsets()->Add(stop_buses.offsets.begin(), stop_buses.offsets.end());
+			catalogue_data.mutable_stop_buses()->Add(stop_buses.buses.begin(), stop_buses.buses.end());
+			*catalogue_data.mutable_stop_name_hash() = GetPerfectNameHashData(catalogue.GetStopNameHash());
+			*catalogue_data.mutable_bus_name_hash() = GetPerfectNameHashData(catalogue.GetBusNameHash());
+			*catalogue_data.mutable_stop_name_trie() = GetNameTrieData(catalogue.GetStopNameTrie());
+
 			return catalogue_data;
 		}
 
@@ -200,6 +233,80 @@ namespace transport_catalogue {
 			return router_proto;
 		}
 
+		transport_catalogue_proto::Labels GetLabelsData(const graph::HubLabels<double>::Labels& labels) {
+			transport_catalogue_proto::Labels labels_proto;
+			// filling labels_proto
+			{
+				for (auto offset : labels.offsets) {
+					labels_proto.add_offsets(offset);
+				}
+				for (const auto& label : labels.labels) {
+					labels_proto.add_hubs(label.hub);
+					labels_proto.add_edges(label.edge);
+					labels_proto.add_weights(label.weight);
+				}
+			}
+
+			return labels_proto;
+		}
+
+		transport_catalogue_proto::HubLabels GetHubLabelsData(const graph::HubLabels<double>& hub_labels) {
+			transport_catalogue_proto::HubLabels hub_labels_proto;
+			// filling hub_labels_proto
+			{
+				for (auto vertex : hub_labels.GetOrder()) {
+					hub_labels_proto.add_order(vertex);
+				}
+				*hub_labels_proto.mutable_forward_labels() = GetLabelsData(hub_labels.GetForwardLabels());
+				*hub_labels_proto.mutable_backward_labels() = GetLabelsData(hub_labels.GetBackwardLabels());
+			}
+
+			return hub_labels_proto;
+		}
+
+		transport_catalogue_proto::Landmarks GetLandmarksData(const graph::Landmarks<double>& landmarks) {
+			transport_catalogue_proto::Landmarks landmarks_proto;
+			// filling landmarks_proto
+			{
+				for (auto vertex : landmarks.GetLandmarks()) {
+					landmarks_proto.add_landmarks(vertex);
+				}
+				*landmarks_proto.mutable_weights_from_landmarks() = {landmarks.GetWeightsFromLandmarks().begin(), landmarks.GetWeightsFromLandmarks().end()};
+				*landmarks_proto.mutable_weights_to_landmarks() = {landmarks.GetWeightsToLandmarks().begin(), landmarks.GetWeightsToLandmarks().end()};
+			}
+
+			return landmarks_proto;
+		}
+
+		transport_catalogue_proto::ReachabilityIndex GetReachabilityIndexData(const graph::ReachabilityIndex& reachability_index) {
+			transport_catalogue_proto::ReachabilityIndex reachability_index_proto;
+			// filling reachability_index_proto
+			{
+				*reachability_index_proto.mutable_components() = {reachability_index.GetComponents().begin(), reachability_index.GetComponents().end()};
+				reachability_index_proto.set_component_count(reachability_index.GetComponentCount());
+				*reachability_index_proto.mutable_reachability() = {reachability_index.GetReachability().begin(), reachability_index.GetReachability().end()};
+				*reachability_index_proto.mutable_component_groups() = {reachability_index.GetComponentGroups().begin(), reachability_index.GetComponentGroups().end()};
+			}
+
+			return reachability_index_proto;
+		}
+
+		transport_catalogue_proto::PartitionOverlay GetPartitionOverlayData(const graph::PartitionOverlay<double>& partition_overlay) {
+			transport_catalogue_proto::PartitionOverlay partition_overlay_proto;
+			// filling partition_overlay_proto
+			{
+				*partition_overlay_proto.mutable_vertex_cells() = {partition_overlay.GetVertexCells().begin(), partition_overlay.GetVertexCells().end()};
+				for (const auto& cell : partition_overlay.GetCells()) {
+					auto& cell_proto = *partition_overlay_proto.add_cells();
+					*cell_proto.mutable_entry_vertices() = {cell.entry_vertices.begin(), cell.entry_vertices.end()};
+					*cell_proto.mutable_exit_vertices() = {cell.exit_vertices.begin(), cell.exit_vertices.end()};
+					*cell_proto.mutable_clique_weights() = {cell.clique_weights.begin(), cell.clique_weights.end()};
+				}
+			}
+
+			return partition_overlay_proto;
+		}
+
 		transport_catalogue_proto::RouterData Serializator::GetRouterDataForSerialization(const transport_router::TransportRouter& router) {
 			transport_catalogue_proto::RouterData router_data;
 
@@ -209,21 +316,58 @@ namespace transport_catalogue {
 			{
 				router_settings_proto.set_bus_wait_time(router_settings.bus_wait_time);
 				router_settings_proto.set_bus_velocity(router_settings.bus_velocity);
+				router_settings_proto.set_routing_mode(static_cast<uint32_t>(router_settings.routing_mode));
+				router_settings_proto.set_landmarks_count(router_settings.landmarks_count);
+				router_settings_proto.set_overlay_cells_count(router_settings.overlay_cells_count);
+				router_settings_proto.set_table_file_name(router_settings.table_file_name);
+				router_settings_proto.set_table_memory_limit(router_settings.table_memory_limit);
+				router_settings_proto.set_search_settle_limit(router_settings.search_limits.settle_limit);
+				router_settings_proto.set_search_time_limit(router_settings.search_limits.time_limit);
+				for (const auto& [bus_name, profile] : router_settings.bus_profiles) {
+					transport_catalogue_proto::BusProfile profile_proto;
+					profile_proto.set_bus_name(bus_name_to_bus_id_[bus_name]);
+					for (const auto& [argument, value] : profile.headway.GetPoints()) {
+						profile_proto.mutable_headway()->add_arguments(argument);
+						profile_proto.mutable_headway()->add_values(value);
+					}
+					for (const auto& [argument, value] : profile.velocity.GetPoints()) {
+						profile_proto.mutable_velocity()->add_arguments(argument);
+						profile_proto.mutable_velocity()->add_values(value);
+					}
+					*router_settings_proto.add_bus_profiles() = move(profile_proto);
+				}
 			}
 			*router_data.mutable_router_settings() = move(router_settings_proto);
 
 			const auto& graph_ptr = router.GetGraphPtr();
 			*router_data.mutable_graph() = GetGraphData(*graph_ptr);
 
-			const auto& router_ptr = router.GetRouterPtr();
-			*router_data.mutable_router() = GetRouterData(*router_ptr);
+			if (const auto& router_ptr = router.GetRouterPtr()) {
+				*router_data.mutable_router() = GetRouterData(*router_ptr);
+			}
+
+			if (const auto& hub_labels_ptr = router.GetHubLabelsPtr()) {
+				*router_data.mutable_hub_labels() = GetHubLabelsData(*hub_labels_ptr);
+			}
+
+			if (const auto& landmarks_ptr = router.GetLandmarksPtr()) {
+				*router_data.mutable_landmarks() = GetLandmarksData(*landmarks_ptr);
+			}
+
+			if (const auto& reachability_index_ptr = router.GetReachabilityIndexPtr()) {
+				*router_data.mutable_reachability_index() = GetReachabilityIndexData(*reachability_index_ptr);
+			}
+
+			if (const auto& partition_overlay_ptr = router.GetPartitionOverlayPtr()) {
+				*router_data.mutable_partition_overlay() = GetPartitionOverlayData(*partition_overlay_ptr);
+			}
 
 			const auto& stop_to_stop_vertex = router.GetStopToStopVertexMap();			
-			for (const auto& [stop_ptr, stop_vertex] : stop_to_stop_vertex) {
+			for (const auto& [stop, stop_vertex] : stop_to_stop_vertex) {
 				transport_catalogue_proto::StopToStopVertex stop_to_stop_vertex_proto;
 				// filling stop_to_stop_vertex_proto
 				{
-					stop_to_stop_vertex_proto.set_stop_name(stop_name_to_stop_id_[stop_ptr->name]);
+					stop_to_stop_vertex_proto.set_stop_name(stop);
 					stop_to_stop_vertex_proto.mutable_stop_vertex()->set_wait(stop_vertex.wait);
 					stop_to_stop_vertex_proto.mutable_stop_vertex()->set_bus(stop_vertex.bus);
 				}
@@ -251,6 +395,17 @@ namespace transport_catalogue {
 				*router_data.add_map_of_edge_id_to_item() = move(edge_id_to_item_proto);
 			}
 
+			const auto& bus_to_first_edge = router.GetBusToFirstEdgeMap();
+			for (const auto& [bus_ptr, first_edge] : bus_to_first_edge) {
+				transport_catalogue_proto::BusToFirstEdge bus_to_first_edge_proto;
+				// filling bus_to_first_edge_proto
+				{
+					bus_to_first_edge_proto.set_bus_name(bus_name_to_bus_id_[string(bus_ptr->name)]);
+					bus_to_first_edge_proto.set_first_edge(first_edge);
+				}
+				*router_data.add_map_of_bus_to_first_edge() = move(bus_to_first_edge_proto);
+			}
+
 				return router_data;
 		}
 
@@ -273,34 +428,65 @@ namespace transport_catalogue {
 			processing_data.SerializePartialToOstream(&output);
         }
 
+		detail::PerfectNameHash GetPerfectNameHashFromData(const transport_catalogue_proto::PerfectNameHash& name_hash_data) {
+			return {name_hash_data.seed(),
+					{name_hash_data.pilots().begin(), name_hash_data.pilots().end()},
+					{name_hash_data.ids().begin(), name_hash_data.ids().end()}};
+		}
+
+		detail::NameTrie GetNameTrieFromData(const transport_catalogue_proto::NameTrie& name_trie_data) {
+			return {{name_trie_data.child_offsets().begin(), name_trie_data.child_offsets().end()},
+					name_trie_data.labels(),
+					{name_trie_data.stops().begin(), name_trie_data.stops().end()}};
+		}
+
         TransportCatalogue Serializator::DeserializeCotalogueData (const transport_catalogue_proto::CatalogueData& catalogue_data) {
 			TransportCatalogue catalogue;
 			// filling catalogue
 			{
 				const auto& stops_proto = catalogue_data.stops();
+				CatalogueBuilder builder(catalogue, stops_proto.size(), catalogue_data.distance_between_stops_size());
+				// номера остановок в базе — их позиции при сохранении
+				vector<domain::StopId> stop_id_to_stop(stops_proto.size());
 				for (const transport_catalogue_proto::Stop& stop : stops_proto) {
-					catalogue.AddStop(stop.name(), { stop.latitude(), stop.longitude() });
+					stop_id_to_stop.at(stop.id()) = builder.AddStop(stop.name(), { stop.latitude(), stop.longitude() });
 					stop_id_to_stop_name_[stop.id()] = stop.name();
 				}
 
 				const auto& buses_proto = catalogue_data.buses();
 				for (const transport_catalogue_proto::Bus& bus : buses_proto) {
-					vector<string> stops(bus.stops_size());
-					for (int i = 0; i < stops.size(); ++i) {
-						string stop_name = stop_id_to_stop_name_[bus.stops(i)];
-						stops[i] = stop_name;
+					vector<domain::StopId> stops;
+					stops.reserve(bus.stops_size());
+					for (const uint32_t stop_id : bus.stops()) {
+						stops.push_back(stop_id_to_stop.at(stop_id));
 					}
 
-					catalogue.AddBus(bus.name(), stops, bus.is_roundtrip());
+					builder.AddBus(bus.name(), move(stops), bus.is_roundtrip());
 					bus_id_to_bus_name_[bus.id()] = bus.name();
 				}
 
+				// в базах без списков автобусов остановок они строятся в Finalize
+				if (catalogue_data.stop_bus_offsets_size() > 0) {
+					StopBuses stop_buses;
+					stop_buses.offsets.assign(catalogue_data.stop_bus_offsets().begin(), catalogue_data.stop_bus_offsets().end());
+					stop_buses.buses.assign(catalogue_data.stop_buses().begin(), catalogue_data.stop_buses().end());
+					catalogue.SetStopBuses(move(stop_buses));
+				}
+
 				const auto& distance_between_stops_proto = catalogue_data.distance_between_stops();
 				for (const auto& distance_data : distance_between_stops_proto) {
-					const auto& stop_from = catalogue.GetStop(stop_id_to_stop_name_[distance_data.stop_from()]);
-					const auto& stop_to = catalogue.GetStop(stop_id_to_stop_name_[distance_data.stop_to()]);
-					catalogue.SetDistance(stop_from, stop_to, distance_data.distance());
+					builder.SetDistance(stop_id_to_stop.at(distance_data.stop_from()), stop_id_to_stop.at(distance_data.stop_to()), distance_data.distance());
+				}
+				builder.Build();
+				// в базах без хеш-функций названий они строятся в Freeze
+				if (catalogue_data.has_stop_name_hash() && catalogue_data.has_bus_name_hash()) {
+					catalogue.SetNameHashes(GetPerfectNameHashFromData(catalogue_data.stop_name_hash()), GetPerfectNameHashFromData(catalogue_data.bus_name_hash()));
 				}
+				// в базах без дерева названий остановок оно строится в Freeze
+				if (catalogue_data.has_stop_name_trie()) {
+					catalogue.SetStopNameTrie(GetNameTrieFromData(catalogue_data.stop_name_trie()));
+				}
+				catalogue.Freeze();
 			}
 
 			return catalogue;
@@ -369,6 +555,22 @@ namespace transport_catalogue {
 			return render_settings;
 		}
 
+		graph::HubLabels<double>::Labels GetLabelsFromLabelsData(const transport_catalogue_proto::Labels& labels_data) {
+			graph::HubLabels<double>::Labels labels;
+			// filling labels
+			{
+				labels.offsets.assign(labels_data.offsets().begin(), labels_data.offsets().end());
+				labels.labels.resize(labels_data.hubs_size());
+				for (int i = 0; i < labels_data.hubs_size(); ++i) {
+					labels.labels[i].hub = labels_data.hubs(i);
+					labels.labels[i].edge = labels_data.edges(i);
+					labels.labels[i].weight = labels_data.weights(i);
+				}
+			}
+
+			return labels;
+		}
+
 		void Serializator::DeserializeRouterData(const transport_catalogue_proto::RouterData& router_data, const TransportCatalogue& catalogue, transport_router::TransportRouter& router) {
 			transport_router::RouterData import_data;
 
@@ -378,6 +580,23 @@ namespace transport_catalogue {
 			{
 				router_settings.bus_wait_time = router_settings_proto.bus_wait_time();
 				router_settings.bus_velocity = router_settings_proto.bus_velocity();
+				router_settings.routing_mode = static_cast<transport_router::RoutingMode>(router_settings_proto.routing_mode());
+				router_settings.landmarks_count = router_settings_proto.landmarks_count();
+				router_settings.overlay_cells_count = router_settings_proto.overlay_cells_count();
+				router_settings.table_file_name = router_settings_proto.table_file_name();
+				router_settings.table_memory_limit = router_settings_proto.table_memory_limit();
+				router_settings.search_limits.settle_limit = router_settings_proto.search_settle_limit();
+				router_settings.search_limits.time_limit = router_settings_proto.search_time_limit();
+				const auto get_function = [](const transport_catalogue_proto::PiecewiseLinearFunction& function_proto) {
+					vector<pair<double, double>> points;
+					for (int i = 0; i < function_proto.arguments_size(); ++i) {
+						points.push_back({function_proto.arguments(i), function_proto.values(i)});
+					}
+					return points.empty() ? graph::PiecewiseLinearFunction{} : graph::PiecewiseLinearFunction(move(points), transport_router::MINUTES_PER_DAY);
+				};
+				for (const auto& profile_proto : router_settings_proto.bus_profiles()) {
+					router_settings.bus_profiles[bus_id_to_bus_name_[profile_proto.bus_name()]] = {get_function(profile_proto.headway()), get_function(profile_proto.velocity())};
+				}
 			}
 
 			const auto& graph_proto = router_data.graph();
@@ -437,8 +656,8 @@ namespace transport_catalogue {
 						stop_vertex_temp.bus = data.stop_vertex().bus();
 					}
 
-					const auto& stop_ptr = catalogue.GetStop(stop_id_to_stop_name_[data.stop_name()]);
-					stop_to_stop_vertex[stop_ptr] = move(stop_vertex_temp);
+					const auto stop = catalogue.GetStop(stop_id_to_stop_name_[data.stop_name()]);
+					stop_to_stop_vertex[stop.value()] = move(stop_vertex_temp);
 				}
 			}
 
@@ -466,6 +685,48 @@ namespace transport_catalogue {
 				}
 			}
 
+			if (router_data.has_hub_labels()) {
+				const auto& hub_labels_proto = router_data.hub_labels();
+				import_data.hub_order.assign(hub_labels_proto.order().begin(), hub_labels_proto.order().end());
+				import_data.forward_labels = GetLabelsFromLabelsData(hub_labels_proto.forward_labels());
+				import_data.backward_labels = GetLabelsFromLabelsData(hub_labels_proto.backward_labels());
+			}
+
+			if (router_data.has_landmarks()) {
+				const auto& landmarks_proto = router_data.landmarks();
+				import_data.landmarks.assign(landmarks_proto.landmarks().begin(), landmarks_proto.landmarks().end());
+				import_data.weights_from_landmarks.assign(landmarks_proto.weights_from_landmarks().begin(), landmarks_proto.weights_from_landmarks().end());
+				import_data.weights_to_landmarks.assign(landmarks_proto.weights_to_landmarks().begin(), landmarks_proto.weights_to_landmarks().end());
+			}
+
+			if (router_data.has_reachability_index()) {
+				const auto& reachability_index_proto = router_data.reachability_index();
+				import_data.components.assign(reachability_index_proto.components().begin(), reachability_index_proto.components().end());
+				import_data.component_count = reachability_index_proto.component_count();
+				import_data.reachability.assign(reachability_index_proto.reachability().begin(), reachability_index_proto.reachability().end());
+				import_data.component_groups.assign(reachability_index_proto.component_groups().begin(), reachability_index_proto.component_groups().end());
+			}
+
+			if (router_data.has_partition_overlay()) {
+				const auto& partition_overlay_proto = router_data.partition_overlay();
+				import_data.vertex_cells.assign(partition_overlay_proto.vertex_cells().begin(), partition_overlay_proto.vertex_cells().end());
+				for (const auto& cell_proto : partition_overlay_proto.cells()) {
+					auto& cell = import_data.overlay_cells.emplace_back();
+					cell.entry_vertices.assign(cell_proto.entry_vertices().begin(), cell_proto.entry_vertices().end());
+					cell.exit_vertices.assign(cell_proto.exit_vertices().begin(), cell_proto.exit_vertices().end());
+					cell.clique_weights.assign(cell_proto.clique_weights().begin(), cell_proto.clique_weights().end());
+				}
+			}
+
+			auto& bus_to_first_edge = import_data.bus_to_first_edge;
+			// filling bus_to_first_edge
+			{
+				for (const auto& data : router_data.map_of_bus_to_first_edge()) {
+					const auto& bus_ptr = catalogue.GetBus(bus_id_to_bus_name_[data.bus_name()]);
+					bus_to_first_edge[bus_ptr] = data.first_edge();
+				}
+			}
+
 			router.SetRouterData(move(import_data));
 		}
 
@@ -483,5 +744,62 @@ namespace transport_catalogue {
 			DeserializeRouterData(processing_data.router(), catalogue, router);
 		}
 
+		void Serializator::SerializeRegionalOverlay(const regional_base::RegionalOverlay& overlay) {
+			transport_catalogue_proto::RegionalOverlay overlay_data;
+			// filling overlay_data
+			{
+				overlay_data.set_regions_count(static_cast<uint32_t>(overlay.regions_count));
+				overlay_data.mutable_stop_names()->Add(overlay.stop_names.begin(), overlay.stop_names.end());
+				overlay_data.mutable_stop_regions()->Add(overlay.stop_regions.begin(), overlay.stop_regions.end());
+				overlay_data.mutable_bus_names()->Add(overlay.bus_names.begin(), overlay.bus_names.end());
+				overlay_data.mutable_bus_regions()->Add(overlay.bus_regions.begin(), overlay.bus_regions.end());
+				overlay_data.mutable_boundary_stops()->Add(overlay.boundary_stops.begin(), overlay.boundary_stops.end());
+				overlay_data.mutable_region_boundary_offsets()->Add(overlay.region_boundary_offsets.begin(), overlay.region_boundary_offsets.end());
+				overlay_data.mutable_region_boundary_stops()->Add(overlay.region_boundary_stops.begin(), overlay.region_boundary_stops.end());
+				overlay_data.mutable_edge_offsets()->Add(overlay.edge_offsets.begin(), overlay.edge_offsets.end());
+				overlay_data.mutable_edge_targets()->Add(overlay.edge_targets.begin(), overlay.edge_targets.end());
+				overlay_data.mutable_edge_times()->Add(overlay.edge_times.begin(), overlay.edge_times.end());
+				overlay_data.set_search_settle_limit(overlay.search_limits.settle_limit);
+				overlay_data.set_search_time_limit(overlay.search_limits.time_limit);
+			}
+
+			std::ofstream output(settings_.file_name, ios::binary);
+			if (!output) throw ios_base::failure("Failed to create a file "s + settings_.file_name);
+			overlay_data.SerializePartialToOstream(&output);
+		}
+
+		regional_base::RegionalOverlay Serializator::DeserializeRegionalOverlay() {
+			ifstream input(settings_.file_name, ios::binary);
+			if (!input) throw std::ios_base::failure("Failed to open a file " + settings_.file_name);
+			transport_catalogue_proto::RegionalOverlay overlay_data;
+			if (!overlay_data.ParseFromIstream(&input)) {
+				throw std::runtime_error("The serialized file cannot be parsed from the istream");
+			}
+
+			regional_base::RegionalOverlay overlay;
+			// filling overlay
+			{
+				overlay.regions_count = overlay_data.regions_count();
+				overlay.stop_names.assign(overlay_data.stop_names().begin(), overlay_data.stop_names().end());
+				overlay.stop_regions.assign(overlay_data.stop_regions().begin(), overlay_data.stop_regions().end());
+				overlay.bus_names.assign(overlay_data.bus_names().begin(), overlay_data.bus_names().end());
+				overlay.bus_regions.assign(overlay_data.bus_regions().begin(), overlay_data.bus_regions().end());
+				overlay.boundary_stops.assign(overlay_data.boundary_stops().begin(), overlay_data.boundary_stops().end());
+				overlay.region_boundary_offsets.assign(overlay_data.region_boundary_offsets().begin(), overlay_data.region_boundary_offsets().end());
+				overlay.region_boundary_stops.assign(overlay_data.region_boundary_stops().begin(), overlay_data.region_boundary_stops().end());
+				overlay.edge_offsets.assign(overlay_data.edge_offsets().begin(), overlay_data.edge_offsets().end());
+				overlay.edge_targets.assign(overlay_data.edge_targets().begin(), overlay_data.edge_targets().end());
+				overlay.edge_times.assign(overlay_data.edge_times().begin(), overlay_data.edge_times().end());
+				overlay.search_limits.settle_limit = overlay_data.search_settle_limit();
+				overlay.search_limits.time_limit = overlay_data.search_time_limit();
+			}
+			if (overlay.stop_regions.size() != overlay.stop_names.size() || overlay.bus_regions.size() != overlay.bus_names.size()
+				|| overlay.region_boundary_offsets.size() != overlay.regions_count + 1 || overlay.edge_offsets.size() != overlay.boundary_stops.size() + 1
+				|| overlay.edge_targets.size() != overlay.edge_times.size()) {
+				throw std::runtime_error("The regional overlay is inconsistent");
+			}
+			return overlay;
+		}
+
     } // namespace serialization
 } // namespace transport_catalogue
\ No newline at end of file
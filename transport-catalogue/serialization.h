@@ -5,6 +5,11 @@
 #include <unordered_map>
 
 #include <graph.pb.h>
+#include <hub_labels.pb.h>
+#include <landmarks.pb.h>
+#include <reachability_index.pb.h>
+#include <partition_overlay.pb.h>
+#include <regional_base.pb.h>
 #include <map_renderer.pb.h>
 #include <svg.pb.h>
 #include <router.pb.h>
@@ -12,6 +17,11 @@
 #include <transport_router.pb.h>
 
 #include "graph.h"
+#include "hub_labels.h"
+#include "landmarks.h"
+#include "reachability_index.h"
+#include "partition_overlay.h"
+#include "regional_base.h"
 #include "map_renderer.h"
 #include "request_handler.h"
 #include "router.h"
@@ -32,6 +42,9 @@ namespace transport_catalogue {
 
             void SerializeData(const TransportCatalogue& catalogue, const map_renderer::MapRenderer& renderer, const transport_router::TransportRouter& router);
             void DeserializeFile(TransportCatalogue& catalogue, map_renderer::MapRenderer& renderer, transport_router::TransportRouter& router);
+            // Оверлей базы, разделённой на регионы, записывается в тот же файл вместо базы
+            void SerializeRegionalOverlay(const regional_base::RegionalOverlay& overlay);
+            regional_base::RegionalOverlay DeserializeRegionalOverlay();
 
         private:
             SerializationSettings settings_;
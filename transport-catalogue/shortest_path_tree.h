@@ -0,0 +1,188 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+#include "search_budget.h"
+
+#include <algorithm>
+#include <functional>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+    // Дерево кратчайших путей из одной вершины, построенное алгоритмом Дейкстры по требованию.
+    // Хранит одну строку таблицы маршрутов Router и восстанавливает пути тем же способом.
+    // Если заданы целевые вершины, поиск останавливается, как только все они достигнуты.
+    // Если поиск прерван исчерпанием budget, запрос пути до недостигнутой вершины бросает SearchBudgetExceeded
+    template <typename Weight>
+    class ShortestPathTree {
+    private:
+        using Graph = DirectedWeightedGraph<Weight>;
+
+    public:
+        ShortestPathTree(const Graph& graph, VertexId from, const std::vector<VertexId>& targets = {}, const SearchBudget& budget = {});
+        // Поиск A* до единственной цели. potential(vertex) возвращает нижнюю оценку расстояния от vertex до цели
+        // (монотонную по рёбрам) либо std::nullopt, если цель из vertex недостижима
+        template <typename Potential>
+        ShortestPathTree(const Graph& graph, VertexId from, VertexId to, const Potential& potential, const SearchBudget& budget = {});
+        // Поиск с весами, зависящими от времени: edge_weight(edge_id, weight) возвращает вес ребра при выходе из его начала
+        // с уже накопленным весом weight. Результат точен, если более поздний выход не даёт более раннего прибытия (FIFO)
+        template <typename EdgeWeight>
+        ShortestPathTree(const Graph& graph, VertexId from, const std::vector<VertexId>& targets, const EdgeWeight& edge_weight,
+                         const SearchBudget& budget = {});
+
+        std::optional<typename Router<Weight>::RouteInfo> BuildRoute(VertexId to) const;
+        std::optional<Weight> GetWeight(VertexId to) const;
+        // Строка таблицы маршрутов Router. Полна, только если дерево построено без целевых вершин
+        const std::vector<std::optional<RouteInternalData<Weight>>>& GetRoutesInternalData() const;
+
+    private:
+        using QueueItem = std::pair<Weight, VertexId>;
+
+        const Graph& graph_;
+        std::vector<std::optional<RouteInternalData<Weight>>> routes_internal_data_;
+        std::vector<bool> is_settled_;
+        bool is_interrupted_ = false;
+
+        bool IsSettled(VertexId vertex) const {
+            if (is_settled_.at(vertex)) {
+                return true;
+            }
+            if (is_interrupted_) {
+                throw SearchBudgetExceeded();
+            }
+            return false;
+        }
+
+        Weight GetStaticEdgeWeight(EdgeId edge_id, Weight) const {
+            return graph_.GetEdge(edge_id).weight;
+        }
+
+        static std::optional<Weight> GetZeroPotential(VertexId) {
+            return Weight{};
+        }
+
+        template <typename Potential, typename EdgeWeight>
+        void Search(VertexId from, const std::vector<VertexId>& targets, const Potential& potential, const EdgeWeight& edge_weight,
+                    const SearchBudget& budget) {
+            std::vector<bool> is_target(targets.empty() ? 0 : graph_.GetVertexCount());
+            size_t targets_left = 0;
+            for (const VertexId target : targets) {
+                if (!is_target.at(target)) {
+                    is_target[target] = true;
+                    ++targets_left;
+                }
+            }
+
+            std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+            const auto from_potential = potential(from);
+            if (!from_potential) {
+                return;
+            }
+            routes_internal_data_.at(from) = RouteInternalData<Weight>{Weight{}, std::nullopt};
+            queue.push({*from_potential, from});
+            size_t settled_count = 0;
+            while (!queue.empty()) {
+                const VertexId vertex = queue.top().second;
+                queue.pop();
+                if (is_settled_[vertex]) {
+                    continue;
+                }
+                if (budget.IsExceeded(++settled_count)) {
+                    is_interrupted_ = true;
+                    break;
+                }
+                is_settled_[vertex] = true;
+                if (!is_target.empty() && is_target[vertex] && --targets_left == 0) {
+                    break;
+                }
+                const Weight weight = routes_internal_data_[vertex]->weight;
+                for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+                    const auto& edge = graph_.GetEdge(edge_id);
+                    const Weight edge_weight_value = edge_weight(edge_id, weight);
+                    if (edge_weight_value < Weight{}) {
+                        throw std::domain_error("Edges' weights should be non-negative");
+                    }
+                    auto& route = routes_internal_data_[edge.to];
+                    const Weight candidate_weight = weight + edge_weight_value;
+                    if (is_settled_[edge.to] || (route && route->weight <= candidate_weight)) {
+                        continue;
+                    }
+                    const auto to_potential = potential(edge.to);
+                    if (!to_potential) {
+                        continue;
+                    }
+                    route = RouteInternalData<Weight>{candidate_weight, edge_id};
+                    queue.push({candidate_weight + *to_potential, edge.to});
+                }
+            }
+        }
+    };
+
+    template <typename Weight>
+    ShortestPathTree<Weight>::ShortestPathTree(const Graph& graph, VertexId from, const std::vector<VertexId>& targets, const SearchBudget& budget)
+        : graph_(graph)
+        , routes_internal_data_(graph.GetVertexCount())
+        , is_settled_(graph.GetVertexCount()) {
+        Search(from, targets, GetZeroPotential, [this](EdgeId edge_id, Weight weight) {
+            return GetStaticEdgeWeight(edge_id, weight);
+        }, budget);
+    }
+
+    template <typename Weight>
+    template <typename Potential>
+    ShortestPathTree<Weight>::ShortestPathTree(const Graph& graph, VertexId from, VertexId to, const Potential& potential, const SearchBudget& budget)
+        : graph_(graph)
+        , routes_internal_data_(graph.GetVertexCount())
+        , is_settled_(graph.GetVertexCount()) {
+        Search(from, {to}, potential, [this](EdgeId edge_id, Weight weight) {
+            return GetStaticEdgeWeight(edge_id, weight);
+        }, budget);
+    }
+
+    template <typename Weight>
+    template <typename EdgeWeight>
+    ShortestPathTree<Weight>::ShortestPathTree(const Graph& graph, VertexId from, const std::vector<VertexId>& targets, const EdgeWeight& edge_weight,
+                                               const SearchBudget& budget)
+        : graph_(graph)
+        , routes_internal_data_(graph.GetVertexCount())
+        , is_settled_(graph.GetVertexCount()) {
+        Search(from, targets, GetZeroPotential, edge_weight, budget);
+    }
+
+    template <typename Weight>
+    std::optional<typename Router<Weight>::RouteInfo> ShortestPathTree<Weight>::BuildRoute(VertexId to) const {
+        if (!IsSettled(to)) {
+            return std::nullopt;
+        }
+        const auto& route_internal_data = routes_internal_data_[to];
+        std::vector<EdgeId> edges;
+        for (std::optional<EdgeId> edge_id = route_internal_data->prev_edge;
+             edge_id;
+             edge_id = routes_internal_data_[graph_.GetEdge(*edge_id).from]->prev_edge)
+        {
+            edges.push_back(*edge_id);
+        }
+        std::reverse(edges.begin(), edges.end());
+
+        return typename Router<Weight>::RouteInfo{route_internal_data->weight, std::move(edges)};
+    }
+
+    template <typename Weight>
+    std::optional<Weight> ShortestPathTree<Weight>::GetWeight(VertexId to) const {
+        if (!IsSettled(to)) {
+            return std::nullopt;
+        }
+        return routes_internal_data_[to]->weight;
+    }
+
+    template <typename Weight>
+    const std::vector<std::optional<RouteInternalData<Weight>>>& ShortestPathTree<Weight>::GetRoutesInternalData() const {
+        return routes_internal_data_;
+    }
+
+}  // namespace graph
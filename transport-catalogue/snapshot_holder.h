@@ -0,0 +1,204 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace transport_catalogue {
+
+    // Хранилище текущей версии неизменяемых данных в стиле RCU. Писатель собирает новую версию отдельно
+    // и публикует её атомарной заменой указателя, читатели закрепляют версию без блокировок и отвечают по ней,
+    // пока держат Pin. Заменённые версии удаляются, когда их не закрепил ни один читатель.
+    // Закрепление защищено hazard-указателями: читатель записывает указатель версии в свою ячейку
+    // и проверяет, что версия всё ещё текущая, а писатель не удаляет версии, записанные в ячейки
+    template <typename Version>
+    class SnapshotHolder {
+    public:
+        // Закреплённая версия, действительна до уничтожения объекта
+        class Pin {
+        public:
+            Pin(Pin&& other) noexcept;
+            Pin& operator=(Pin&& other) noexcept;
+            Pin(const Pin&) = delete;
+            Pin& operator=(const Pin&) = delete;
+            ~Pin();
+
+            const Version& operator*() const;
+            const Version* operator->() const;
+
+        private:
+            friend class SnapshotHolder;
+
+            const SnapshotHolder* holder_ = nullptr;
+            size_t slot_ = 0;
+            const Version* version_ = nullptr;
+
+            Pin(const SnapshotHolder* holder, size_t slot, const Version* version);
+            void Release();
+        };
+
+        SnapshotHolder() = default;
+        explicit SnapshotHolder(std::unique_ptr<const Version> version);
+        SnapshotHolder(const SnapshotHolder&) = delete;
+        SnapshotHolder& operator=(const SnapshotHolder&) = delete;
+        // к моменту уничтожения закреплённых версий быть не должно
+        ~SnapshotHolder();
+
+        // Закрепляет текущую версию. Одновременно закреплено не больше MAX_PINS версий,
+        // иначе выбрасывается std::runtime_error. Без опубликованной версии выбрасывается std::logic_error
+        Pin Acquire() const;
+        // Делает version текущей и удаляет заменённые версии, которые больше не закреплены. Писатели публикуют по очереди
+        void Publish(std::unique_ptr<const Version> version);
+        // Удаляет заменённые версии, которые больше не закреплены
+        void Reclaim();
+        bool IsEmpty() const;
+        // Количество заменённых, но ещё закреплённых версий
+        size_t GetRetiredCount() const;
+
+    private:
+        static constexpr size_t MAX_PINS = 64;
+
+        std::atomic<const Version*> current_{nullptr};
+        // ячейки читателей: занятость ячейки и указатель закреплённой версии
+        mutable std::array<std::atomic<bool>, MAX_PINS> is_slot_busy_{};
+        mutable std::array<std::atomic<const Version*>, MAX_PINS> hazards_{};
+
+        mutable std::mutex writer_mutex_;
+        std::vector<std::unique_ptr<const Version>> retired_;
+    };
+
+    template <typename Version>
+    SnapshotHolder<Version>::Pin::Pin(const SnapshotHolder* holder, size_t slot, const Version* version)
+        : holder_(holder)
+        , slot_(slot)
+        , version_(version) {
+    }
+
+    template <typename Version>
+    SnapshotHolder<Version>::Pin::Pin(Pin&& other) noexcept
+        : holder_(std::exchange(other.holder_, nullptr))
+        , slot_(other.slot_)
+        , version_(std::exchange(other.version_, nullptr)) {
+    }
+
+    template <typename Version>
+    typename SnapshotHolder<Version>::Pin& SnapshotHolder<Version>::Pin::operator=(Pin&& other) noexcept {
+        if (this != &other) {
+            Release();
+            holder_ = std::exchange(other.holder_, nullptr);
+            slot_ = other.slot_;
+            version_ = std::exchange(other.version_, nullptr);
+        }
+        return *this;
+    }
+
+    template <typename Version>
+    SnapshotHolder<Version>::Pin::~Pin() {
+        Release();
+    }
+
+    template <typename Version>
+    const Version& SnapshotHolder<Version>::Pin::operator*() const {
+        return *version_;
+    }
+
+    template <typename Version>
+    const Version* SnapshotHolder<Version>::Pin::operator->() const {
+        return version_;
+    }
+
+    template <typename Version>
+    void SnapshotHolder<Version>::Pin::Release() {
+        if (holder_) {
+            holder_->hazards_[slot_].store(nullptr);
+            holder_->is_slot_busy_[slot_].store(false, std::memory_order_release);
+            holder_ = nullptr;
+        }
+    }
+
+    template <typename Version>
+    SnapshotHolder<Version>::SnapshotHolder(std::unique_ptr<const Version> version)
+        : current_(version.release()) {
+    }
+
+    template <typename Version>
+    SnapshotHolder<Version>::~SnapshotHolder() {
+        delete current_.load();
+    }
+
+    template <typename Version>
+    typename SnapshotHolder<Version>::Pin SnapshotHolder<Version>::Acquire() const {
+        size_t slot = 0;
+        for (bool expected = false; slot < MAX_PINS; ++slot, expected = false) {
+            if (is_slot_busy_[slot].compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+                break;
+            }
+        }
+        if (slot == MAX_PINS) {
+            throw std::runtime_error("Too many pinned versions");
+        }
+
+        // версия могла смениться между чтением указателя и записью его в ячейку, тогда писатель её не видел
+        const Version* version = current_.load();
+        for (;;) {
+            hazards_[slot].store(version);
+            const Version* current = current_.load();
+            if (current == version) {
+                break;
+            }
+            version = current;
+        }
+        if (!version) {
+            hazards_[slot].store(nullptr);
+            is_slot_busy_[slot].store(false, std::memory_order_release);
+            throw std::logic_error("No published version");
+        }
+        return Pin(this, slot, version);
+    }
+
+    template <typename Version>
+    void SnapshotHolder<Version>::Publish(std::unique_ptr<const Version> version) {
+        {
+            std::lock_guard guard(writer_mutex_);
+            if (const Version* old_version = current_.exchange(version.release())) {
+                retired_.emplace_back(old_version);
+            }
+        }
+        Reclaim();
+    }
+
+    template <typename Version>
+    bool SnapshotHolder<Version>::IsEmpty() const {
+        return current_.load() == nullptr;
+    }
+
+    template <typename Version>
+    size_t SnapshotHolder<Version>::GetRetiredCount() const {
+        std::lock_guard guard(writer_mutex_);
+        return retired_.size();
+    }
+
+    template <typename Version>
+    void SnapshotHolder<Version>::Reclaim() {
+        std::lock_guard guard(writer_mutex_);
+        std::vector<const Version*> pinned;
+        for (const auto& hazard : hazards_) {
+            if (const Version* version = hazard.load()) {
+                pinned.push_back(version);
+            }
+        }
+        std::vector<std::unique_ptr<const Version>> still_pinned;
+        for (auto& version : retired_) {
+            if (std::find(pinned.begin(), pinned.end(), version.get()) != pinned.end()) {
+                still_pinned.push_back(std::move(version));
+            }
+        }
+        retired_ = std::move(still_pinned);
+    }
+
+} // namespace transport_catalogue
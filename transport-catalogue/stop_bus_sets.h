@@ -0,0 +1,110 @@
+#pragma once
+
+#include "domain.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+namespace transport_catalogue {
+    namespace detail {
+
+        // Множества автобусов остановок для пересечения. Как в roaring-множествах, представление выбирается
+        // по размеру: множество остановки, через которую проходит много автобусов, хранится битовой строкой
+        // по номерам автобусов, остальные — упорядоченным по номерам списком. Битовая строка выбирается,
+        // когда она не длиннее списка, и пересекается с другой строкой по словам
+        class StopBusSets {
+        public:
+            // Автобусы остановки stop — buses[offsets[stop], offsets[stop + 1]) без повторов, номера меньше buses_count
+            void Build(const std::vector<std::uint32_t>& offsets, const std::vector<domain::BusIndex>& buses, size_t buses_count);
+
+            // Автобусы, проходящие через обе остановки, по возрастанию номеров
+            std::vector<domain::BusIndex> Intersect(domain::StopId lhs, domain::StopId rhs) const;
+
+        private:
+            static constexpr std::uint32_t NO_BITSET = UINT32_MAX;
+            static constexpr size_t WORD_BITS = 64;
+
+            size_t words_per_bitset_ = 0;
+            // список остановки stop — buses_[offsets_[stop], offsets_[stop + 1]), у остановок с битовой строкой пустой
+            std::vector<std::uint32_t> offsets_;
+            std::vector<domain::BusIndex> buses_;
+            // номер битовой строки остановки или NO_BITSET, строка i — words_[i * words_per_bitset_, (i + 1) * words_per_bitset_)
+            std::vector<std::uint32_t> bitsets_;
+            std::vector<std::uint64_t> words_;
+
+            const std::uint64_t* GetBitset(domain::StopId stop) const;
+            bool Contains(const std::uint64_t* bitset, domain::BusIndex bus) const;
+        };
+
+        inline void StopBusSets::Build(const std::vector<std::uint32_t>& offsets, const std::vector<domain::BusIndex>& buses, size_t buses_count) {
+            const size_t stops_count = offsets.empty() ? 0 : offsets.size() - 1;
+            words_per_bitset_ = (buses_count + WORD_BITS - 1) / WORD_BITS;
+            offsets_.assign(1, 0);
+            offsets_.reserve(stops_count + 1);
+            buses_.clear();
+            bitsets_.assign(stops_count, NO_BITSET);
+            words_.clear();
+            std::uint32_t bitsets_count = 0;
+            for (domain::StopId stop = 0; stop < stops_count; ++stop) {
+                const auto begin = buses.begin() + offsets[stop];
+                const auto end = buses.begin() + offsets[stop + 1];
+                const size_t count = static_cast<size_t>(end - begin);
+                if (count > 0 && count * sizeof(domain::BusIndex) >= words_per_bitset_ * sizeof(std::uint64_t)) {
+                    bitsets_[stop] = bitsets_count++;
+                    words_.resize(words_.size() + words_per_bitset_);
+                    std::uint64_t* bitset = words_.data() + words_.size() - words_per_bitset_;
+                    for (auto it = begin; it != end; ++it) {
+                        bitset[*it / WORD_BITS] |= std::uint64_t{1} << (*it % WORD_BITS);
+                    }
+                } else {
+                    const size_t list_begin = buses_.size();
+                    buses_.insert(buses_.end(), begin, end);
+                    std::sort(buses_.begin() + list_begin, buses_.end());
+                }
+                offsets_.push_back(static_cast<std::uint32_t>(buses_.size()));
+            }
+            buses_.shrink_to_fit();
+            words_.shrink_to_fit();
+        }
+
+        inline std::vector<domain::BusIndex> StopBusSets::Intersect(domain::StopId lhs, domain::StopId rhs) const {
+            std::vector<domain::BusIndex> result;
+            if (lhs >= bitsets_.size() || rhs >= bitsets_.size()) {
+                return result;
+            }
+            const std::uint64_t* lhs_bitset = GetBitset(lhs);
+            const std::uint64_t* rhs_bitset = GetBitset(rhs);
+            if (lhs_bitset && rhs_bitset) {
+                for (size_t i = 0; i < words_per_bitset_; ++i) {
+                    for (std::uint64_t word = lhs_bitset[i] & rhs_bitset[i]; word != 0; word &= word - 1) {
+                        result.push_back(static_cast<domain::BusIndex>(i * WORD_BITS + __builtin_ctzll(word)));
+                    }
+                }
+            } else if (lhs_bitset || rhs_bitset) {
+                const std::uint64_t* bitset = lhs_bitset ? lhs_bitset : rhs_bitset;
+                const domain::StopId list_stop = lhs_bitset ? rhs : lhs;
+                for (std::uint32_t i = offsets_[list_stop]; i < offsets_[list_stop + 1]; ++i) {
+                    if (Contains(bitset, buses_[i])) {
+                        result.push_back(buses_[i]);
+                    }
+                }
+            } else {
+                std::set_intersection(buses_.begin() + offsets_[lhs], buses_.begin() + offsets_[lhs + 1],
+                                      buses_.begin() + offsets_[rhs], buses_.begin() + offsets_[rhs + 1],
+                                      std::back_inserter(result));
+            }
+            return result;
+        }
+
+        inline const std::uint64_t* StopBusSets::GetBitset(domain::StopId stop) const {
+            return bitsets_[stop] == NO_BITSET ? nullptr : words_.data() + bitsets_[stop] * words_per_bitset_;
+        }
+
+        inline bool StopBusSets::Contains(const std::uint64_t* bitset, domain::BusIndex bus) const {
+            return bitset[bus / WORD_BITS] >> (bus % WORD_BITS) & 1;
+        }
+
+    } // namespace detail
+} // namespace transport_catalogue
@@ -1,7 +1,12 @@
 #include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <limits>
 #include <numeric>
+#include <stdexcept>
+#include <string>
 #include "transport_catalogue.h"
+#include <tuple>
 #include <utility>
 
 #include "log_duration.h"
@@ -10,63 +15,274 @@ using namespace std;
 
 namespace transport_catalogue {
 
-    void TransportCatalogue::AddBus(const string& bus_name, vector<string>& stops, bool is_roundtrip) {
+    void TransportCatalogue::Reserve(size_t stops_count, size_t distances_count) {
+        CheckNotFrozen();
+        stop_names_.reserve(stops_count);
+        stop_latitudes_.reserve(stops_count);
+        stop_longitudes_.reserve(stops_count);
+        stop_points_.Reserve(stops_count);
+        stop_ids_.Reserve(stops_count, stop_names_);
+        distance_between_stops_.reserve(distances_count);
+    }
+
+    void TransportCatalogue::AddBus(string_view bus_name, vector<domain::StopId> stops, bool is_roundtrip) {
+        CheckNotFrozen();
         domain::Bus new_bus;
-        new_bus.name = bus_name;
-        for (const auto& stop : stops) {
-            new_bus.stops.push_back(GetStop(stop));
-        }
+        new_bus.name = names_.Add(bus_name);
+        new_bus.stops = move(stops);
         new_bus.is_roundtrip = is_roundtrip;
         buses_.push_back(move(new_bus));
-        buses_pointers_[buses_.back().name] = &buses_.back();
-        for (const auto& stop : stops) {
-            AddBusesForStop(GetStop(stop)->name, &buses_.back());
-        }
+        bus_stats_.total_stops_numbers.push_back(0);
+        bus_stats_.unique_stops_numbers.push_back(0);
+        bus_stats_.route_lengths.push_back(0);
+        bus_stats_.route_curvatures.push_back(0);
+        bus_stats_.is_actual.push_back(0);
+        are_buses_by_name_actual_ = false;
+        are_name_hashes_actual_ = false;
+        are_stop_buses_actual_ = false;
     }
 
-    void TransportCatalogue::AddStop(const string& stop_name, geo::Coordinates&& coordinates) {
-        domain::Stop new_stop{stop_name, move(coordinates)};
-        stops_.push_back(move(new_stop));
-        stops_pointers_[stops_.back().name] = &stops_.back();
+    domain::StopId TransportCatalogue::AddStop(string_view stop_name, geo::Coordinates coordinates) {
+        CheckNotFrozen();
+        const auto stop = static_cast<domain::StopId>(stop_names_.size());
+        stop_names_.push_back(names_.Add(stop_name));
+        stop_latitudes_.push_back(coordinates.lat);
+        stop_longitudes_.push_back(coordinates.lng);
+        stop_points_.Add(coordinates);
+        are_stop_buses_actual_ = false;
+        stop_ids_.Insert(stop, stop_names_);
+        are_name_hashes_actual_ = false;
+        is_stop_name_trie_actual_ = false;
+        return stop;
     }
 
-    void TransportCatalogue::AddBusesForStop(std::string_view stop_name, const domain::Bus* bus) {
-        buses_for_stop_[stop_name].insert(bus);
+    void TransportCatalogue::SetStopCoordinates(domain::StopId stop, geo::Coordinates coordinates) {
+        CheckNotFrozen();
+        stop_latitudes_[stop] = coordinates.lat;
+        stop_longitudes_[stop] = coordinates.lng;
+        stop_points_.Set(stop, coordinates);
+        for (const domain::BusIndex bus : GetBusesForStop(stop)) {
+            ResetRouteInfo(bus);
+        }
     }
 
     const domain::Bus* TransportCatalogue::GetBus(string_view bus_name) const {
-        auto it = buses_pointers_.find(bus_name);
-        if (it == buses_pointers_.end()) {
+        if (is_frozen_) {
+            const domain::BusIndex bus = bus_name_hash_.Find(bus_name);
+            if (bus == detail::PerfectNameHash::NOT_FOUND || buses_[bus].name != bus_name) {
+                return nullptr;
+            }
+            return &buses_[bus];
+        }
+        const auto it = lower_bound(buses_by_name_.begin(), buses_by_name_.end(), bus_name, [this](domain::BusIndex bus, string_view name) {
+            return buses_[bus].name < name;
+        });
+        if (it == buses_by_name_.end() || buses_[*it].name != bus_name) {
             return nullptr;
         }
-        return it->second;
+        return &buses_[*it];
     }
 
-    const domain::Stop* TransportCatalogue::GetStop(string_view stop_name) const {
-        auto it = stops_pointers_.find(stop_name);
-        if (it == stops_pointers_.end()) {
-            return nullptr;
+    optional<domain::StopId> TransportCatalogue::GetStop(string_view stop_name) const {
+        if (is_frozen_) {
+            const domain::StopId stop = stop_name_hash_.Find(stop_name);
+            if (stop == detail::PerfectNameHash::NOT_FOUND || stop_names_[stop] != stop_name) {
+                return nullopt;
+            }
+            return stop;
         }
-        return it->second;
+        return stop_ids_.Find(stop_name, stop_names_);
     }
 
-    const unordered_set<const domain::Bus*>* TransportCatalogue::GetBusesForStop(string_view stop_name) const {
-        auto it = buses_for_stop_.find(stop_name);
-        if (it == buses_for_stop_.end()) {
-            return nullptr;
+    string_view TransportCatalogue::GetStopName(domain::StopId stop) const {
+        return stop_names_[stop];
+    }
+
+    geo::Coordinates TransportCatalogue::GetStopCoordinates(domain::StopId stop) const {
+        return {stop_latitudes_[stop], stop_longitudes_[stop]};
+    }
+
+    size_t TransportCatalogue::GetStopsCount() const {
+        return stop_names_.size();
+    }
+
+    const vector<double>& TransportCatalogue::GetStopLatitudes() const {
+        return stop_latitudes_;
+    }
+
+    const vector<double>& TransportCatalogue::GetStopLongitudes() const {
+        return stop_longitudes_;
+    }
+
+    const domain::Bus& TransportCatalogue::GetBusByIndex(domain::BusIndex bus) const {
+        return buses_[bus];
+    }
+
+    ranges::Range<const domain::BusIndex*> TransportCatalogue::GetBusesForStop(domain::StopId stop) const {
+        if (stop + 1 >= stop_buses_.offsets.size()) {
+            return {nullptr, nullptr};
+        }
+        const domain::BusIndex* buses = stop_buses_.buses.data();
+        return {buses + stop_buses_.offsets[stop], buses + stop_buses_.offsets[stop + 1]};
+    }
+
+    const StopBuses& TransportCatalogue::GetStopBuses() const {
+        return stop_buses_;
+    }
+
+    void TransportCatalogue::SetStopBuses(StopBuses&& stop_buses) {
+        CheckNotFrozen();
+        stop_buses_ = move(stop_buses);
+        are_stop_buses_actual_ = true;
+        are_stop_bus_sets_actual_ = false;
+    }
+
+    vector<domain::BusIndex> TransportCatalogue::GetDirectBuses(domain::StopId from, domain::StopId to) const {
+        vector<domain::BusIndex> buses;
+        if (from == to) {
+            return buses;
+        }
+        // порядок остановок проверяется только у автобусов из пересечения и только у кольцевых
+        for (const domain::BusIndex bus : stop_bus_sets_.Intersect(from, to)) {
+            const vector<domain::StopId>& stops = buses_[bus].stops;
+            if (!buses_[bus].is_roundtrip || find(find(stops.begin(), stops.end(), from), stops.end(), to) != stops.end()) {
+                buses.push_back(bus);
+            }
+        }
+        sort(buses.begin(), buses.end(), [this](domain::BusIndex lhs, domain::BusIndex rhs) {
+            return buses_[lhs].name < buses_[rhs].name;
+        });
+        return buses;
+    }
+
+    const detail::PerfectNameHash& TransportCatalogue::GetStopNameHash() const {
+        return stop_name_hash_;
+    }
+
+    const detail::PerfectNameHash& TransportCatalogue::GetBusNameHash() const {
+        return bus_name_hash_;
+    }
+
+    void TransportCatalogue::SetNameHashes(detail::PerfectNameHash stop_name_hash, detail::PerfectNameHash bus_name_hash) {
+        CheckNotFrozen();
+        stop_name_hash_ = move(stop_name_hash);
+        bus_name_hash_ = move(bus_name_hash);
+        are_name_hashes_actual_ = true;
+    }
+
+    vector<domain::StopId> TransportCatalogue::FindStopsByPrefix(string_view prefix, size_t limit) const {
+        return stop_name_trie_.FindByPrefix(prefix, limit);
+    }
+
+    vector<domain::StopId> TransportCatalogue::FindSimilarStops(string_view stop_name, size_t max_distance, size_t limit) const {
+        return stop_name_trie_.FindSimilar(stop_name, max_distance, limit);
+    }
+
+    const detail::NameTrie& TransportCatalogue::GetStopNameTrie() const {
+        return stop_name_trie_;
+    }
+
+    void TransportCatalogue::SetStopNameTrie(detail::NameTrie stop_name_trie) {
+        CheckNotFrozen();
+        stop_name_trie_ = move(stop_name_trie);
+        is_stop_name_trie_actual_ = true;
+    }
+
+    void TransportCatalogue::CollectUniqueStopNames(vector<string_view>& names, vector<uint32_t>& ids) const {
+        names.clear();
+        ids.clear();
+        names.reserve(stop_names_.size());
+        ids.reserve(stop_names_.size());
+        for (domain::StopId stop = 0; stop < stop_names_.size(); ++stop) {
+            if (stop_ids_.Find(stop_names_[stop], stop_names_) == stop) {
+                names.push_back(stop_names_[stop]);
+                ids.push_back(stop);
+            }
+        }
+    }
+
+    void TransportCatalogue::BuildStopNameTrie() {
+        vector<string_view> names;
+        vector<uint32_t> ids;
+        CollectUniqueStopNames(names, ids);
+        stop_name_trie_.Build(names, ids);
+        is_stop_name_trie_actual_ = true;
+    }
+
+    void TransportCatalogue::BuildNameHashes() {
+        vector<string_view> names;
+        vector<uint32_t> ids;
+        CollectUniqueStopNames(names, ids);
+        stop_name_hash_.Build(names, ids);
+
+        names.clear();
+        ids.clear();
+        for (const domain::BusIndex bus : buses_by_name_) {
+            names.push_back(buses_[bus].name);
+            ids.push_back(bus);
         }
-        return &it->second;
+        bus_name_hash_.Build(names, ids);
+        are_name_hashes_actual_ = true;
     }
 
-    void TransportCatalogue::SetDistance(const domain::Stop* from, const domain::Stop* to, int distance) {
+    void TransportCatalogue::BuildBusesByName() {
+        buses_by_name_.resize(buses_.size());
+        iota(buses_by_name_.begin(), buses_by_name_.end(), 0);
+        const auto by_name = [this](domain::BusIndex lhs, domain::BusIndex rhs) {
+            return buses_[lhs].name < buses_[rhs].name;
+        };
+        stable_sort(buses_by_name_.begin(), buses_by_name_.end(), by_name);
+        // из одноимённых автобусов остаётся последний добавленный
+        const auto last = unique(buses_by_name_.rbegin(), buses_by_name_.rend(), [this](domain::BusIndex lhs, domain::BusIndex rhs) {
+            return buses_[lhs].name == buses_[rhs].name;
+        });
+        buses_by_name_.erase(buses_by_name_.begin(), last.base());
+        is_bus_by_name_.assign(buses_.size(), 0);
+        for (const domain::BusIndex bus : buses_by_name_) {
+            is_bus_by_name_[bus] = 1;
+        }
+        are_buses_by_name_actual_ = true;
+    }
+
+    void TransportCatalogue::BuildStopBuses() {
+        // автобусы перебираются в порядке названий, поэтому списки остановок получаются упорядоченными.
+        // Повтор остановки в маршруте оставляет автобус последним в её списке
+        const auto for_each_bus_stop = [&](const auto& action) {
+            vector<domain::BusIndex> last_bus(stop_names_.size(), numeric_limits<domain::BusIndex>::max());
+            for (const domain::BusIndex bus : buses_by_name_) {
+                for (const domain::StopId stop : buses_[bus].stops) {
+                    if (last_bus[stop] != bus) {
+                        last_bus[stop] = bus;
+                        action(stop, bus);
+                    }
+                }
+            }
+        };
+        stop_buses_.offsets.assign(stop_names_.size() + 1, 0);
+        for_each_bus_stop([this](domain::StopId stop, domain::BusIndex) {
+            ++stop_buses_.offsets[stop + 1];
+        });
+        partial_sum(stop_buses_.offsets.begin(), stop_buses_.offsets.end(), stop_buses_.offsets.begin());
+        stop_buses_.buses.resize(stop_buses_.offsets.back());
+        vector<uint32_t> positions(stop_buses_.offsets.begin(), stop_buses_.offsets.end() - 1);
+        for_each_bus_stop([this, &positions](domain::StopId stop, domain::BusIndex bus) {
+            stop_buses_.buses[positions[stop]++] = bus;
+        });
+        are_stop_buses_actual_ = true;
+        are_stop_bus_sets_actual_ = false;
+    }
+
+    void TransportCatalogue::SetDistance(domain::StopId from, domain::StopId to, int distance) {
+        CheckNotFrozen();
         distance_between_stops_[{from, to}] = distance;
+        // расстояние входит в длину только тех маршрутов, которые проходят через обе остановки
+        for (const domain::BusIndex bus : GetBusesForStop(from)) {
+            ResetRouteInfo(bus);
+        }
     }
 
     int TransportCatalogue::GetUniqueStopsNumber(const domain::Bus& bus) const {
-        unordered_set<string_view> unique_stops;
-        for (const auto& stop : bus.stops) {
-            unique_stops.insert(stop->name);
-        }
+        unordered_set<domain::StopId> unique_stops(bus.stops.begin(), bus.stops.end());
         return static_cast<int>(unique_stops.size());
     }
 
@@ -77,40 +293,285 @@ namespace transport_catalogue {
         return static_cast<int>(bus.stops.size()) * 2 - 1;
     }
 
-    double TransportCatalogue::GetRouteLengthGeo(std::vector<const domain::Stop*> stops) const {
-        double result = 0;
-        for (size_t i = 0; i < stops.size(); ++i) {
-            if (i == stops.size() - 1) {
-                break;
-            }
-            result += ComputeDistance(stops[i]->coordinates, stops[i + 1]->coordinates);
+    double TransportCatalogue::GetRouteLengthGeo(const std::vector<domain::StopId>& stops) const {
+        return stop_points_.ComputePathLength(stops.data(), stops.data() + stops.size());
+    }
+
+    int TransportCatalogue::GetDistance(domain::StopId from, domain::StopId to) const {
+        const detail::NeighborDistance* neighbor = FindNeighbor(from, to);
+        if (distance_between_stops_.empty()) {
+            return neighbor ? neighbor->distance : 0;
         }
-        return result;
+        // заданное расстояние важнее обратного, новое — важнее записанного в списки
+        if (const auto it = distance_between_stops_.find({from, to}); it != distance_between_stops_.end()) {
+            return it->second;
+        }
+        if (neighbor && !neighbor->is_reverse) {
+            return neighbor->distance;
+        }
+        if (const auto it = distance_between_stops_.find({to, from}); it != distance_between_stops_.end()) {
+            return it->second;
+        }
+        return neighbor ? neighbor->distance : 0;
     }
 
-    int TransportCatalogue::GetDistance(const domain::Stop* from, const domain::Stop* to) const {
-        if (distance_between_stops_.count({from, to}) != 0) {
-            return distance_between_stops_.at({from, to});
-        } else if (distance_between_stops_.count({to, from}) != 0) {
-            return distance_between_stops_.at({to, from});
+    const detail::NeighborDistance* TransportCatalogue::FindNeighbor(domain::StopId from, domain::StopId to) const {
+        if (from + 1 >= neighbor_offsets_.size()) {
+            return nullptr;
+        }
+        const auto begin = neighbors_.begin() + neighbor_offsets_[from];
+        const auto end = neighbors_.begin() + neighbor_offsets_[from + 1];
+        const auto it = lower_bound(begin, end, to, [](const detail::NeighborDistance& neighbor, domain::StopId stop) {
+            return neighbor.stop < stop;
+        });
+        if (it == end || it->stop != to) {
+            return nullptr;
+        }
+        return &*it;
+    }
+
+    void TransportCatalogue::BuildNeighborDistances() {
+        struct Distance {
+            domain::StopId from;
+            domain::StopId to;
+            bool is_reverse;
+            int distance;
+        };
+        const auto by_stops = [](const Distance& lhs, const Distance& rhs) {
+            return tie(lhs.from, lhs.to, lhs.is_reverse) < tie(rhs.from, rhs.to, rhs.is_reverse);
+        };
+        const auto is_same_stops = [](const Distance& lhs, const Distance& rhs) {
+            return lhs.from == rhs.from && lhs.to == rhs.to;
+        };
+
+        // заданные расстояния: новые идут раньше записанных в списки и при совпадении остаются они
+        vector<Distance> distances;
+        distances.reserve(neighbors_.size() + distance_between_stops_.size());
+        for (const auto& [stops, distance] : distance_between_stops_) {
+            distances.push_back({stops.first, stops.second, false, distance});
+        }
+        for (domain::StopId from = 0; from + 1 < neighbor_offsets_.size(); ++from) {
+            for (uint32_t i = neighbor_offsets_[from]; i < neighbor_offsets_[from + 1]; ++i) {
+                if (!neighbors_[i].is_reverse) {
+                    distances.push_back({from, neighbors_[i].stop, false, neighbors_[i].distance});
+                }
+            }
+        }
+        stable_sort(distances.begin(), distances.end(), by_stops);
+        distances.erase(unique(distances.begin(), distances.end(), is_same_stops), distances.end());
+
+        // обратные расстояния добавляются там, где нет заданных
+        const size_t explicit_count = distances.size();
+        for (size_t i = 0; i < explicit_count; ++i) {
+            distances.push_back({distances[i].to, distances[i].from, true, distances[i].distance});
         }
-        return 0;
+        sort(distances.begin(), distances.end(), by_stops);
+        distances.erase(unique(distances.begin(), distances.end(), is_same_stops), distances.end());
+
+        neighbor_offsets_.assign(stop_names_.size() + 1, 0);
+        neighbors_.clear();
+        neighbors_.reserve(distances.size());
+        for (const Distance& distance : distances) {
+            ++neighbor_offsets_[distance.from + 1];
+            neighbors_.push_back({distance.to, distance.is_reverse, distance.distance});
+        }
+        partial_sum(neighbor_offsets_.begin(), neighbor_offsets_.end(), neighbor_offsets_.begin());
+        // clear() оставил бы массив корзин хеш-таблицы
+        decltype(distance_between_stops_)().swap(distance_between_stops_);
     }
 
-    int TransportCatalogue::GetRouteLength(const vector<const domain::Stop*>& stops, bool is_roundtrip) const {
+    int TransportCatalogue::GetRouteLength(const vector<domain::StopId>& stops, bool is_roundtrip) const {
         int result = 0;
-        for (size_t i = 0; i < stops.size() - 1; ++i) {
+        for (size_t i = 0; i + 1 < stops.size(); ++i) {
             result += GetDistance(stops[i], stops[i + 1]);
         }
         if (!is_roundtrip) {
-            for (size_t i = stops.size() - 1; i > 0; --i) {
-                result += GetDistance(stops[i], stops[i - 1]);
+            for (size_t i = stops.size(); i > 1; --i) {
+                result += GetDistance(stops[i - 1], stops[i - 2]);
             }
         }
         return result;
     }
 
     domain::RouteInfo TransportCatalogue::GetRouteInfo(const domain::Bus* bus) const {
+        const auto index = static_cast<domain::BusIndex>(bus - buses_.data());
+        if (bus_stats_.is_actual[index]) {
+            return {bus_stats_.total_stops_numbers[index], bus_stats_.unique_stops_numbers[index],
+                    bus_stats_.route_lengths[index], bus_stats_.route_curvatures[index]};
+        }
+        return ComputeRouteInfo(bus);
+    }
+
+    const BusStats& TransportCatalogue::GetBusStats() const {
+        return bus_stats_;
+    }
+
+    // Вызывает action со столбцом поля field
+    template <typename Action>
+    void VisitBusStatColumn(const BusStats& bus_stats, domain::BusStatField field, Action action) {
+        switch (field) {
+            case domain::BusStatField::STOP_COUNT:
+                action(bus_stats.total_stops_numbers);
+                break;
+            case domain::BusStatField::UNIQUE_STOP_COUNT:
+                action(bus_stats.unique_stops_numbers);
+                break;
+            case domain::BusStatField::ROUTE_LENGTH:
+                action(bus_stats.route_lengths);
+                break;
+            case domain::BusStatField::CURVATURE:
+                action(bus_stats.route_curvatures);
+                break;
+        }
+    }
+
+    // Извилистость автобуса нулевой геодлины (из одной остановки или остановок с одинаковыми координатами) — NaN или inf,
+    // у такого автобуса значения нет
+    template <typename Value>
+    bool HasStatValue(Value value) {
+        if constexpr (is_floating_point_v<Value>) {
+            return isfinite(value);
+        } else {
+            return true;
+        }
+    }
+
+    // Сумма значений отобранных автобусов: умножение на флаг вместо условия позволяет компилятору векторизовать цикл
+    int64_t SumSelected(const vector<int>& column, const vector<char>& is_selected) {
+        int64_t sum = 0;
+        for (size_t bus = 0; bus < column.size(); ++bus) {
+            sum += static_cast<int64_t>(column[bus]) * is_selected[bus];
+        }
+        return sum;
+    }
+
+    domain::BusStatsReport TransportCatalogue::GetBusStatsReport(const domain::BusStatsQuery& query) const {
+        vector<char> is_selected = is_bus_by_name_;
+        is_selected.resize(buses_.size());
+        for (const domain::BusStatFilter& filter : query.filters) {
+            VisitBusStatColumn(bus_stats_, filter.field, [&is_selected, &filter](const auto& column) {
+                for (size_t bus = 0; bus < column.size(); ++bus) {
+                    is_selected[bus] &= static_cast<char>(HasStatValue(column[bus]) & (column[bus] >= filter.min) & (column[bus] <= filter.max));
+                }
+            });
+        }
+
+        domain::BusStatsReport report;
+        for (const char selected : is_selected) {
+            report.bus_count += selected;
+        }
+        report.total_stops_number = SumSelected(bus_stats_.total_stops_numbers, is_selected);
+        report.unique_stops_number = SumSelected(bus_stats_.unique_stops_numbers, is_selected);
+        report.route_length = SumSelected(bus_stats_.route_lengths, is_selected);
+        if (!query.sort_by || query.limit == 0) {
+            return report;
+        }
+
+        report.buses.reserve(report.bus_count);
+        for (domain::BusIndex bus = 0; bus < is_selected.size(); ++bus) {
+            if (is_selected[bus]) {
+                report.buses.push_back(bus);
+            }
+        }
+        const size_t limit = min(query.limit, report.buses.size());
+        VisitBusStatColumn(bus_stats_, *query.sort_by, [this, &report, &query, limit](const auto& column) {
+            partial_sort(report.buses.begin(), report.buses.begin() + limit, report.buses.end(), [this, &query, &column](domain::BusIndex lhs, domain::BusIndex rhs) {
+                const bool lhs_has_value = HasStatValue(column[lhs]);
+                if (lhs_has_value != HasStatValue(column[rhs])) {
+                    return lhs_has_value;
+                }
+                if (lhs_has_value && column[lhs] != column[rhs]) {
+                    return query.is_ascending ? column[lhs] < column[rhs] : column[lhs] > column[rhs];
+                }
+                return buses_[lhs].name < buses_[rhs].name;
+            });
+        });
+        report.buses.resize(limit);
+        return report;
+    }
+
+    void TransportCatalogue::Finalize() {
+        if (is_frozen_) {
+            return;
+        }
+        if (!are_buses_by_name_actual_) {
+            BuildBusesByName();
+        }
+        if (!are_stop_buses_actual_) {
+            BuildStopBuses();
+        }
+        if (!are_stop_bus_sets_actual_) {
+            stop_bus_sets_.Build(stop_buses_.offsets, stop_buses_.buses, buses_.size());
+            are_stop_bus_sets_actual_ = true;
+        }
+        BuildNeighborDistances();
+        for (domain::BusIndex bus = 0; bus < buses_.size(); ++bus) {
+            if (!bus_stats_.is_actual[bus]) {
+                SetRouteInfo(bus, ComputeRouteInfo(&buses_[bus]));
+            }
+        }
+    }
+
+    void TransportCatalogue::Freeze() {
+        if (is_frozen_) {
+            return;
+        }
+        Finalize();
+        if (!are_name_hashes_actual_) {
+            BuildNameHashes();
+        }
+        if (!is_stop_name_trie_actual_) {
+            BuildStopNameTrie();
+        }
+        stop_ids_ = {};
+        // названия остановок по номерам, затем названия автобусов в порядке поиска по ним переписываются подряд в один блок
+        size_t names_size = 0;
+        for (const string_view name : stop_names_) {
+            names_size += name.size();
+        }
+        for (const domain::Bus& bus : buses_) {
+            names_size += bus.name.size();
+        }
+        detail::NameArena names(names_size);
+        for (string_view& name : stop_names_) {
+            name = names.Add(name);
+        }
+        vector<bool> is_bus_name_moved(buses_.size());
+        for (const domain::BusIndex bus : buses_by_name_) {
+            buses_[bus].name = names.Add(buses_[bus].name);
+            is_bus_name_moved[bus] = true;
+        }
+        // одноимённые автобусы, которые не попали в поиск по названию
+        for (size_t bus = 0; bus < buses_.size(); ++bus) {
+            if (!is_bus_name_moved[bus]) {
+                buses_[bus].name = names.Add(buses_[bus].name);
+            }
+        }
+        names_ = move(names);
+
+        stop_names_.shrink_to_fit();
+        stop_latitudes_.shrink_to_fit();
+        stop_longitudes_.shrink_to_fit();
+        buses_.shrink_to_fit();
+        bus_stats_.total_stops_numbers.shrink_to_fit();
+        bus_stats_.unique_stops_numbers.shrink_to_fit();
+        bus_stats_.route_lengths.shrink_to_fit();
+        bus_stats_.route_curvatures.shrink_to_fit();
+        bus_stats_.is_actual.shrink_to_fit();
+        is_frozen_ = true;
+    }
+
+    bool TransportCatalogue::IsFrozen() const {
+        return is_frozen_;
+    }
+
+    void TransportCatalogue::CheckNotFrozen() const {
+        if (is_frozen_) {
+            throw logic_error("Catalogue is frozen");
+        }
+    }
+
+    domain::RouteInfo TransportCatalogue::ComputeRouteInfo(const domain::Bus* bus) const {
         int total_stops_number = GetTotalStopsNumber(*bus);
         int unique_stops_number = GetUniqueStopsNumber(*bus);
         int route_length = GetRouteLength(bus->stops, bus->is_roundtrip);
@@ -120,28 +581,152 @@ namespace transport_catalogue {
         return {total_stops_number, unique_stops_number, route_length, route_curvature};
     }
 
-    const map<string_view, const domain::Bus*>* TransportCatalogue::GetBusesList() const {
-        return &buses_pointers_;
+    void TransportCatalogue::SetRouteInfo(domain::BusIndex bus, const domain::RouteInfo& route_info) {
+        bus_stats_.total_stops_numbers[bus] = route_info.total_stops_number;
+        bus_stats_.unique_stops_numbers[bus] = route_info.unique_stops_number;
+        bus_stats_.route_lengths[bus] = route_info.route_length;
+        bus_stats_.route_curvatures[bus] = route_info.route_curvature;
+        bus_stats_.is_actual[bus] = 1;
+    }
+
+    void TransportCatalogue::ResetRouteInfo(domain::BusIndex bus) {
+        bus_stats_.is_actual[bus] = 0;
     }
 
-    const std::unordered_map<std::string_view, const domain::Stop*>* TransportCatalogue::GetStopsList() const {
-        return &stops_pointers_;
+    const vector<domain::BusIndex>& TransportCatalogue::GetBusesByName() const {
+        return buses_by_name_;
     }
 
-    const deque<domain::Bus>& TransportCatalogue::GetAllBuses() const {
+    const vector<domain::Bus>& TransportCatalogue::GetAllBuses() const {
         return buses_;
     }
 
-    const deque<domain::Stop>& TransportCatalogue::GetAllStops() const {
-        return stops_;
+    vector<pair<pair<domain::StopId, domain::StopId>, int>> TransportCatalogue::GetDistanceBetweenStopsList() const {
+        vector<pair<pair<domain::StopId, domain::StopId>, int>> distances(distance_between_stops_.begin(), distance_between_stops_.end());
+        for (domain::StopId from = 0; from + 1 < neighbor_offsets_.size(); ++from) {
+            for (uint32_t i = neighbor_offsets_[from]; i < neighbor_offsets_[from + 1]; ++i) {
+                const detail::NeighborDistance& neighbor = neighbors_[i];
+                if (!neighbor.is_reverse && !distance_between_stops_.count({from, neighbor.stop})) {
+                    distances.push_back({{from, neighbor.stop}, neighbor.distance});
+                }
+            }
+        }
+        return distances;
+    }
+
+    size_t detail::PairHasher::operator()(const std::pair<domain::StopId, domain::StopId> pair_of_stops) const noexcept {
+        return hasher_(static_cast<std::uint64_t>(pair_of_stops.first) << 32 | pair_of_stops.second);
+    }
+
+    void detail::StopNameIndex::Insert(domain::StopId stop, const vector<string_view>& stop_names) {
+        // таблица заполняется не больше чем наполовину
+        if ((size_ + 1) * 2 > slots_.size()) {
+            Rehash(max<size_t>(16, slots_.size() * 2), stop_names);
+        }
+        domain::StopId& slot = slots_[FindSlot(stop_names[stop], stop_names)];
+        if (slot == EMPTY_SLOT) {
+            ++size_;
+        }
+        slot = stop;
+    }
+
+    void detail::StopNameIndex::Reserve(size_t count, const vector<string_view>& stop_names) {
+        size_t slots_count = max<size_t>(16, slots_.size());
+        while (count * 2 > slots_count) {
+            slots_count *= 2;
+        }
+        if (slots_count > slots_.size()) {
+            Rehash(slots_count, stop_names);
+        }
+    }
+
+    // Переносит остановки в таблицу из slots_count ячеек, slots_count — степень двойки
+    void detail::StopNameIndex::Rehash(size_t slots_count, const vector<string_view>& stop_names) {
+        vector<domain::StopId> old_slots(slots_count, EMPTY_SLOT);
+        swap(slots_, old_slots);
+        size_ = 0;
+        for (const domain::StopId old_stop : old_slots) {
+            if (old_stop != EMPTY_SLOT) {
+                slots_[FindSlot(stop_names[old_stop], stop_names)] = old_stop;
+                ++size_;
+            }
+        }
+    }
+
+    optional<domain::StopId> detail::StopNameIndex::Find(string_view stop_name, const vector<string_view>& stop_names) const {
+        if (slots_.empty()) {
+            return nullopt;
+        }
+        const domain::StopId stop = slots_[FindSlot(stop_name, stop_names)];
+        if (stop == EMPTY_SLOT) {
+            return nullopt;
+        }
+        return stop;
+    }
+
+    // Ячейка с этим названием или первая свободная ячейка после неё при линейном пробировании
+    size_t detail::StopNameIndex::FindSlot(string_view stop_name, const vector<string_view>& stop_names) const {
+        const size_t mask = slots_.size() - 1;
+        for (size_t slot = hash<string_view>{}(stop_name) & mask; ; slot = (slot + 1) & mask) {
+            if (slots_[slot] == EMPTY_SLOT || stop_names[slots_[slot]] == stop_name) {
+                return slot;
+            }
+        }
+    }
+
+    CatalogueBuilder::CatalogueBuilder(TransportCatalogue& catalogue, size_t stops_count, size_t distances_count)
+        : catalogue_(catalogue) {
+        catalogue_.Reserve(stops_count, distances_count);
+    }
+
+    domain::StopId CatalogueBuilder::AddStop(string_view stop_name, geo::Coordinates coordinates) {
+        return catalogue_.AddStop(stop_name, coordinates);
+    }
+
+    domain::StopId CatalogueBuilder::SetStop(string_view stop_name, geo::Coordinates coordinates) {
+        if (const auto stop = catalogue_.GetStop(stop_name)) {
+            catalogue_.SetStopCoordinates(*stop, coordinates);
+            return *stop;
+        }
+        return catalogue_.AddStop(stop_name, coordinates);
+    }
+
+    void CatalogueBuilder::AddCatalogue(const TransportCatalogue& other) {
+        const domain::StopId first_stop = static_cast<domain::StopId>(catalogue_.GetStopsCount());
+        for (domain::StopId stop = 0; stop < other.GetStopsCount(); ++stop) {
+            catalogue_.AddStop(other.GetStopName(stop), other.GetStopCoordinates(stop));
+        }
+        for (const domain::BusIndex bus_index : other.GetBusesByName()) {
+            const domain::Bus& bus = other.GetBusByIndex(bus_index);
+            vector<domain::StopId> stops = bus.stops;
+            for (domain::StopId& stop : stops) {
+                stop += first_stop;
+            }
+            catalogue_.AddBus(bus.name, move(stops), bus.is_roundtrip);
+        }
+        for (const auto& [stops, distance] : other.GetDistanceBetweenStopsList()) {
+            catalogue_.SetDistance(stops.first + first_stop, stops.second + first_stop, distance);
+        }
+    }
+
+    domain::StopId CatalogueBuilder::GetStop(string_view stop_name) const {
+        const auto stop = catalogue_.GetStop(stop_name);
+        if (!stop) {
+            throw out_of_range("Unknown stop "s + string(stop_name));
+        }
+        return *stop;
+    }
+
+    void CatalogueBuilder::AddBus(string_view bus_name, vector<domain::StopId> stops, bool is_roundtrip) {
+        catalogue_.AddBus(bus_name, move(stops), is_roundtrip);
     }
 
-    const unordered_map<pair<const domain::Stop*, const domain::Stop*>, int, detail::PairHasher>& TransportCatalogue::GetDistanceBetweenStopsList() const {
-        return distance_between_stops_;
+    void CatalogueBuilder::SetDistance(domain::StopId from, domain::StopId to, int distance) {
+        catalogue_.SetDistance(from, to, distance);
     }
 
-    size_t detail::PairHasher::operator()(const std::pair<const domain::Stop*, const domain::Stop*> pair_of_stops) const noexcept {
-        return hasher_(pair_of_stops.first) * 17 + hasher_(pair_of_stops.second) * 17 * 17;
+    void CatalogueBuilder::Build() {
+        catalogue_.Finalize();
     }
 
 } // end of namespace transport_catalogue
\ No newline at end of file
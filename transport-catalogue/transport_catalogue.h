@@ -1,10 +1,15 @@
 #pragma once
 
-#include <deque>
 #include "domain.h"
-#include <map>
+#include "geo.h"
+#include <limits>
+#include "name_arena.h"
+#include "name_trie.h"
 #include <optional>
+#include "perfect_hash.h"
+#include "ranges.h"
 #include <set>
+#include "stop_bus_sets.h"
 #include <string>
 #include <string_view>
 #include <unordered_map>
@@ -15,50 +20,208 @@ namespace transport_catalogue {
     namespace detail {
 
             struct PairHasher {
-                size_t operator()(const std::pair<const domain::Stop*, const domain::Stop*> pair_of_stops) const noexcept;
+                size_t operator()(const std::pair<domain::StopId, domain::StopId> pair_of_stops) const noexcept;
                 
             private:
-                std::hash<const void*> hasher_;
+                std::hash<std::uint64_t> hasher_;
+            };
+
+            // Расстояние до соседней остановки. Расстояние, заданное в одну сторону, записывается и соседу
+            // как обратное (is_reverse), если у него нет собственного, поэтому расстояние ищется в одном списке
+            struct NeighborDistance {
+                std::uint32_t stop : 31;
+                std::uint32_t is_reverse : 1;
+                int distance;
+            };
+
+            // Индекс названий остановок с открытой адресацией: ячейка таблицы хранит только номер остановки,
+            // а название для сравнения берётся из массива названий справочника
+            class StopNameIndex {
+            public:
+                void Reserve(size_t count, const std::vector<std::string_view>& stop_names);
+                void Insert(domain::StopId stop, const std::vector<std::string_view>& stop_names);
+                std::optional<domain::StopId> Find(std::string_view stop_name, const std::vector<std::string_view>& stop_names) const;
+
+            private:
+                static constexpr domain::StopId EMPTY_SLOT = std::numeric_limits<domain::StopId>::max();
+
+                std::vector<domain::StopId> slots_;
+                size_t size_ = 0;
+
+                size_t FindSlot(std::string_view stop_name, const std::vector<std::string_view>& stop_names) const;
+                void Rehash(size_t slots_count, const std::vector<std::string_view>& stop_names);
             };
 
         } // namespace detail
 
+    // Автобусы остановок: номера автобусов остановки stop — buses[offsets[stop], offsets[stop + 1]),
+    // без повторов и в порядке названий автобусов
+    struct StopBuses {
+        std::vector<std::uint32_t> offsets;
+        std::vector<domain::BusIndex> buses;
+    };
+
+    // Значения RouteInfo по столбцам: i-й элемент столбца относится к автобусу i,
+    // поэтому отчёт по всем автобусам читает подряд только нужные ему поля
+    struct BusStats {
+        std::vector<int> total_stops_numbers;
+        std::vector<int> unique_stops_numbers;
+        std::vector<int> route_lengths;
+        std::vector<double> route_curvatures;
+        // 1, если значения автобуса рассчитаны
+        std::vector<char> is_actual;
+    };
+
+    // Справочник заполняется AddStop, AddBus и SetDistance, после чего Finalize строит производные данные.
+    // Freeze переводит справочник в режим только для чтения: константные методы не изменяют его состояние,
+    // поэтому замороженный справочник можно читать из нескольких потоков без блокировок
     class TransportCatalogue {
         public:            
 
-            void AddBus(const std::string& bus_name, std::vector<std::string>& stops, bool is_roundtrip);
-            void AddStop(const std::string& stop_name, geo::Coordinates&& coordinates);
+            // Резервирует место под остановки и заданные расстояния, чтобы при загрузке не перераспределять память
+            void Reserve(size_t stops_count, size_t distances_count);
+            // Ссылки на автобусы действительны до следующего добавления автобуса
+            void AddBus(std::string_view bus_name, std::vector<domain::StopId> stops, bool is_roundtrip);
+            domain::StopId AddStop(std::string_view stop_name, geo::Coordinates coordinates);
+            // Сбрасывает RouteInfo автобусов через остановку до следующего Finalize
+            void SetStopCoordinates(domain::StopId stop, geo::Coordinates coordinates);
                                 
+            // Ищет среди автобусов, добавленных до последнего Finalize
             const domain::Bus* GetBus(std::string_view bus_name) const;
-            const domain::Stop* GetStop(std::string_view stop_name) const;
+            std::optional<domain::StopId> GetStop(std::string_view stop_name) const;
+
+            std::string_view GetStopName(domain::StopId stop) const;
+            geo::Coordinates GetStopCoordinates(domain::StopId stop) const;
+            size_t GetStopsCount() const;
+            // координаты остановок хранятся отдельными массивами широт и долгот по номерам остановок
+            const std::vector<double>& GetStopLatitudes() const;
+            const std::vector<double>& GetStopLongitudes() const;
+
+            const domain::Bus& GetBusByIndex(domain::BusIndex bus) const;
+            // Автобусы остановки в порядке названий. Список строится в Finalize, автобусы, добавленные позже, в него не входят
+            ranges::Range<const domain::BusIndex*> GetBusesForStop(domain::StopId stop) const;
+            const StopBuses& GetStopBuses() const;
+            // Загружает сохранённые списки автобусов остановок, Finalize их не перестраивает
+            void SetStopBuses(StopBuses&& stop_buses);
+            // Автобусы, на которых можно доехать от from до to без пересадок, в порядке названий: кольцевые, на которых
+            // from встречается раньше to, и некольцевые через обе остановки. Множества автобусов остановок строятся в Finalize
+            std::vector<domain::BusIndex> GetDirectBuses(domain::StopId from, domain::StopId to) const;
 
-            const std::unordered_set<const domain::Bus*>* GetBusesForStop(std::string_view stop_name) const;
+            // Совершенные хеш-функции названий остановок и автобусов, по которым ищет замороженный справочник
+            const detail::PerfectNameHash& GetStopNameHash() const;
+            const detail::PerfectNameHash& GetBusNameHash() const;
+            // Загружает сохранённые хеш-функции, Freeze их не перестраивает
+            void SetNameHashes(detail::PerfectNameHash stop_name_hash, detail::PerfectNameHash bus_name_hash);
 
-            void SetDistance(const domain::Stop* from, const domain::Stop* to, int distance);
-            int GetDistance(const domain::Stop* from, const domain::Stop* to) const;
+            // Поиск по префиксному дереву названий остановок, которое строит Freeze. До Freeze остановки не находятся.
+            // До limit остановок, названия которых начинаются с prefix, в порядке названий
+            std::vector<domain::StopId> FindStopsByPrefix(std::string_view prefix, size_t limit) const;
+            // До limit остановок, названия которых отличаются от stop_name не больше чем на max_distance правок,
+            // начиная с самых близких
+            std::vector<domain::StopId> FindSimilarStops(std::string_view stop_name, size_t max_distance, size_t limit) const;
+            const detail::NameTrie& GetStopNameTrie() const;
+            // Загружает сохранённое дерево, Freeze его не перестраивает
+            void SetStopNameTrie(detail::NameTrie stop_name_trie);
+
+            void SetDistance(domain::StopId from, domain::StopId to, int distance);
+            int GetDistance(domain::StopId from, domain::StopId to) const;
             
             domain::RouteInfo GetRouteInfo(const domain::Bus* bus) const;
+            const BusStats& GetBusStats() const;
+            // Отчёт по автобусам, которые находятся по названию, по значениям, рассчитанным в последнем Finalize.
+            // Фильтры и суммы считаются проходами по столбцам без ветвлений, упорядочиваются только отобранные автобусы
+            domain::BusStatsReport GetBusStatsReport(const domain::BusStatsQuery& query) const;
+            // Строит списки автобусов остановок, переносит заданные расстояния в списки соседей и рассчитывает RouteInfo всех автобусов, для которых нет
+            // рассчитанного значения. Вызывается после загрузки, изменение расстояний сбрасывает значения автобусов
+            // через эти остановки до следующего вызова
+            void Finalize();
+            // Вызывает Finalize, строит совершенные хеш-функции названий вместо индекса остановок и дерево названий остановок
+            // и переписывает названия в один блок, освобождая память изменяемых структур.
+            // После этого AddStop, AddBus, SetDistance и загрузка списков выбрасывают std::logic_error
+            void Freeze();
+            bool IsFrozen() const;
 
-            const std::map<std::string_view, const domain::Bus*>* GetBusesList() const;
-            const std::unordered_map<std::string_view, const domain::Stop*>* GetStopsList() const;
+            // номера автобусов в порядке названий, из одноимённых автобусов — последний добавленный
+            const std::vector<domain::BusIndex>& GetBusesByName() const;
 
-            const std::deque<domain::Bus>& GetAllBuses() const;
-            const std::deque<domain::Stop>& GetAllStops() const;
-            const std::unordered_map<std::pair<const domain::Stop*, const domain::Stop*>, int, detail::PairHasher>& GetDistanceBetweenStopsList() const;
+            const std::vector<domain::Bus>& GetAllBuses() const;
+            // заданные расстояния без обратных
+            std::vector<std::pair<std::pair<domain::StopId, domain::StopId>, int>> GetDistanceBetweenStopsList() const;
 
         private:
-            std::deque<domain::Bus> buses_;
-            std::deque<domain::Stop> stops_;
-            std::unordered_map<std::string_view, const domain::Stop*> stops_pointers_;
-            std::map<std::string_view, const domain::Bus*> buses_pointers_;
-            std::unordered_map<std::string_view, std::unordered_set<const domain::Bus*>> buses_for_stop_;
-            std::unordered_map<std::pair<const domain::Stop*, const domain::Stop*>, int, detail::PairHasher> distance_between_stops_;
-
-            void AddBusesForStop(std::string_view stop_name, const domain::Bus* bus);
+            // названия остановок и автобусов
+            detail::NameArena names_;
+            std::vector<domain::Bus> buses_;
+            std::vector<std::string_view> stop_names_;
+            std::vector<double> stop_latitudes_;
+            std::vector<double> stop_longitudes_;
+            // те же координаты на единичной сфере для расчёта расстояний без тригонометрии широты и долготы
+            geo::SpherePoints stop_points_;
+            detail::StopNameIndex stop_ids_;
+            std::vector<domain::BusIndex> buses_by_name_;
+            // 1 у автобусов из buses_by_name_
+            std::vector<char> is_bus_by_name_;
+            StopBuses stop_buses_;
+            // порядок автобусов и списки автобусов остановок соответствуют текущим остановкам и автобусам
+            bool are_buses_by_name_actual_ = true;
+            bool are_stop_buses_actual_ = true;
+            // те же списки в виде множеств для пересечения
+            detail::StopBusSets stop_bus_sets_;
+            bool are_stop_bus_sets_actual_ = true;
+            // после Freeze названия ищутся по хеш-функциям, индекс остановок освобождается
+            detail::PerfectNameHash stop_name_hash_;
+            detail::PerfectNameHash bus_name_hash_;
+            bool are_name_hashes_actual_ = false;
+            detail::NameTrie stop_name_trie_;
+            bool is_stop_name_trie_actual_ = false;
+            bool is_frozen_ = false;
+            // соседи остановки stop — neighbors_[neighbor_offsets_[stop], neighbor_offsets_[stop + 1]), упорядоченные по номеру
+            std::vector<std::uint32_t> neighbor_offsets_;
+            std::vector<detail::NeighborDistance> neighbors_;
+            // расстояния, заданные после последнего Finalize, переопределяют списки соседей
+            std::unordered_map<std::pair<domain::StopId, domain::StopId>, int, detail::PairHasher> distance_between_stops_;
+            // рассчитанные значения по номерам автобусов
+            BusStats bus_stats_;
+
+            void CheckNotFrozen() const;
+            void BuildBusesByName();
+            void BuildStopBuses();
+            // Названия и номера остановок без повторов: из одноимённых остаётся последняя добавленная, как в индексе
+            void CollectUniqueStopNames(std::vector<std::string_view>& names, std::vector<std::uint32_t>& ids) const;
+            void BuildNameHashes();
+            void BuildStopNameTrie();
+            const detail::NeighborDistance* FindNeighbor(domain::StopId from, domain::StopId to) const;
+            void BuildNeighborDistances();
+            domain::RouteInfo ComputeRouteInfo(const domain::Bus* bus) const;
+            void SetRouteInfo(domain::BusIndex bus, const domain::RouteInfo& route_info);
+            void ResetRouteInfo(domain::BusIndex bus);
             int GetUniqueStopsNumber(const domain::Bus& bus) const;
             int GetTotalStopsNumber(const domain::Bus& bus) const;
-            double GetRouteLengthGeo(std::vector<const domain::Stop*> stops) const;
-            int GetRouteLength(const std::vector<const domain::Stop*>& stops, bool is_roundtrip) const;
+            double GetRouteLengthGeo(const std::vector<domain::StopId>& stops) const;
+            int GetRouteLength(const std::vector<domain::StopId>& stops, bool is_roundtrip) const;
         };
 
+    // Загрузка справочника из разобранных запросов: названия передаются как string_view на входные данные
+    // и копируются только в хранилище справочника, место под остановки резервируется заранее.
+    // Остановки автобусов ищутся по названию по одному разу, автобусы остановок и списки соседей строятся в Build
+    class CatalogueBuilder {
+        public:
+            CatalogueBuilder(TransportCatalogue& catalogue, size_t stops_count, size_t distances_count);
+
+            domain::StopId AddStop(std::string_view stop_name, geo::Coordinates coordinates);
+            // Задаёт координаты остановки с этим названием, если она уже есть, и добавляет новую, если нет
+            domain::StopId SetStop(std::string_view stop_name, geo::Coordinates coordinates);
+            // Добавляет остановки, автобусы и заданные расстояния другого справочника. Остановки получают номера
+            // подряд после уже добавленных, в пустом справочнике — те же, что в other. Из одноимённых автобусов переносится последний
+            void AddCatalogue(const TransportCatalogue& other);
+            // Остановка с этим названием должна быть добавлена раньше, иначе выбрасывается std::out_of_range
+            domain::StopId GetStop(std::string_view stop_name) const;
+            void AddBus(std::string_view bus_name, std::vector<domain::StopId> stops, bool is_roundtrip);
+            void SetDistance(domain::StopId from, domain::StopId to, int distance);
+            void Build();
+
+        private:
+            TransportCatalogue& catalogue_;
+    };
+
 } // end of namespace transport_catalogue
\ No newline at end of file
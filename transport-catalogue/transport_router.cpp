@@ -1,4 +1,12 @@
 #include "transport_router.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iterator>
+#include <set>
+#include <stdexcept>
 #include <utility>
 
 using namespace std;
@@ -10,33 +18,394 @@ namespace transport_catalogue {
             : catalogue_(catalogue), router_settings_(settings) {
             BuildAllRoutes();
         }
+        TransportRouter::TransportRouter(const TransportCatalogue& catalogue, const TransportRouter& other) : catalogue_(catalogue) {
+            RouterData data;
+            data.settings = other.router_settings_;
+            data.edges = other.graph_->GetEdges();
+            data.incidence_lists = other.graph_->GetIncidenceLists();
+            if (other.router_) {
+                data.routes_iternal_data = other.router_->GetRoutesInternalData();
+            }
+            if (other.hub_labels_) {
+                data.hub_order = other.hub_labels_->GetOrder();
+                data.forward_labels = other.hub_labels_->GetForwardLabels();
+                data.backward_labels = other.hub_labels_->GetBackwardLabels();
+            }
+            if (other.landmarks_) {
+                data.landmarks = other.landmarks_->GetLandmarks();
+                data.weights_from_landmarks = other.landmarks_->GetWeightsFromLandmarks();
+                data.weights_to_landmarks = other.landmarks_->GetWeightsToLandmarks();
+            }
+            if (other.reachability_index_) {
+                data.components = other.reachability_index_->GetComponents();
+                data.component_count = other.reachability_index_->GetComponentCount();
+                data.component_groups = other.reachability_index_->GetComponentGroups();
+                data.reachability = other.reachability_index_->GetReachability();
+            }
+            if (other.partition_overlay_) {
+                data.vertex_cells = other.partition_overlay_->GetVertexCells();
+                data.overlay_cells = other.partition_overlay_->GetCells();
+            }
+            data.stop_to_stop_vertex = other.stop_to_stop_vertex_;
+            data.edge_id_to_item = other.edge_id_to_item_;
+            for (const auto& [bus, first_edge] : other.bus_to_first_edge_) {
+                const domain::Bus* catalogue_bus = catalogue.GetBus(bus->name);
+                if (!catalogue_bus) {
+                    throw invalid_argument("Bus "s + string(bus->name) + " is missing in the catalogue"s);
+                }
+                data.bus_to_first_edge[catalogue_bus] = first_edge;
+            }
+            SetRouterData(move(data));
+        }
 
-        StopVertex TransportRouter::GetStopVertex(const domain::Stop* stop) const {
+        StopVertex TransportRouter::GetStopVertex(domain::StopId stop) const {
             return stop_to_stop_vertex_.at(stop);
         }
 
-        optional<TransportRouter::RouteItems> TransportRouter::GetRouteByStops(string_view stop_from_name, string_view stop_to_name) const {
+        vector<string_view> GetRouteStopNames(string_view stop_from_name, const vector<string_view>& via_stop_names, string_view stop_to_name) {
+            vector<string_view> stop_names;
+            stop_names.reserve(via_stop_names.size() + 2);
+            stop_names.push_back(stop_from_name);
+            stop_names.insert(stop_names.end(), via_stop_names.begin(), via_stop_names.end());
+            stop_names.push_back(stop_to_name);
+            return stop_names;
+        }
+
+        // Вершины остановок маршрута, std::nullopt — если остановка неизвестна или отрезок заведомо недостижим
+        optional<vector<StopVertex>> TransportRouter::FindReachableStops(const vector<string_view>& stop_names) const {
+            vector<StopVertex> stops;
+            stops.reserve(stop_names.size());
+            for (const string_view stop_name : stop_names) {
+                const auto stop = FindStopVertex(stop_name);
+                if (!stop || (!stops.empty() && reachability_index_ && !reachability_index_->IsReachable(stops.back().wait, stop->wait))) {
+                    return nullopt;
+                }
+                stops.push_back(*stop);
+            }
+            return stops;
+        }
+
+        optional<StopVertex> TransportRouter::FindStopVertex(string_view stop_name) const {
+            const auto stop = catalogue_.GetStop(stop_name);
+            if (!stop) {
+                return nullopt;
+            }
+            const auto it = stop_to_stop_vertex_.find(*stop);
+            if (it == stop_to_stop_vertex_.end()) {
+                return nullopt;
+            }
+            return it->second;
+        }
+
+        graph::SearchBudget MakeSearchBudget(const SearchLimits& limits) {
+            optional<graph::SearchBudget::Clock::duration> time_limit;
+            if (limits.time_limit > 0) {
+                time_limit = chrono::milliseconds(limits.time_limit);
+            }
+            return {static_cast<size_t>(max(limits.settle_limit, 0)), time_limit};
+        }
+
+        optional<graph::Router<double>::RouteInfo> TransportRouter::BuildRoute(graph::VertexId from, graph::VertexId to, const graph::SearchBudget& budget) const {
+            if (reachability_index_ && !reachability_index_->IsReachable(from, to)) {
+                return nullopt;
+            }
+            if (hub_labels_) {
+                return hub_labels_->BuildRoute(from, to);
+            } else if (partition_overlay_) {
+                return partition_overlay_->BuildRoute(from, to, budget);
+            } else if (paged_routes_table_) {
+                return paged_routes_table_->BuildRoute(from, to);
+            } else if (router_) {
+                return router_->BuildRoute(from, to);
+            } else if (landmarks_) {
+                return graph::ShortestPathTree<double>(*graph_, from, to, [this, to](graph::VertexId vertex) {
+                    return landmarks_->GetLowerBound(vertex, to);
+                }, budget).BuildRoute(to);
+            }
+            return graph::ShortestPathTree<double>(*graph_, from, vector<graph::VertexId>{to}, budget).BuildRoute(to);
+        }
+
+        size_t TransportRouter::RepairRoutes(graph::EdgeId edge_id, double old_weight) {
+            if (router_) {
+                return router_->UpdateEdge(edge_id, old_weight);
+            }
+            RebuildChangedRoutes();
+            return 0;
+        }
+
+        // Индексы, которые не восстанавливаются по одному ребру, после изменения графа
+        void TransportRouter::RebuildChangedRoutes() {
+            // удалённое ребро могло быть межъячеечным, лишние входы и выходы ячеек на результат не влияют
+            if (partition_overlay_) {
+                partition_overlay_->Customize();
+                reachability_index_ = make_unique<graph::ReachabilityIndex>(*graph_);
+                return;
+            }
+            BuildRouteIndex();
+        }
+
+        TransportRouter::RouteItems TransportRouter::GetRouteItems(const graph::Router<double>::RouteInfo& route_info) const {
             RouteItems items_info;
-            auto stop_from = catalogue_.GetStop(stop_from_name);
-            auto stop_to = catalogue_.GetStop(stop_to_name);
-            auto router_info = router_->BuildRoute(GetStopVertex(stop_from).wait, GetStopVertex(stop_to).wait);
+            items_info.total_time = route_info.weight;
+            for (const auto& edge : route_info.edges) {
+                items_info.items.push_back(edge_id_to_item_.at(edge));
+            }
+            return items_info;
+        }
+
+        optional<TransportRouter::RouteItems> TransportRouter::GetRouteByStops(string_view stop_from_name, string_view stop_to_name) const {
+            return GetRouteByStops(stop_from_name, stop_to_name, router_settings_.search_limits);
+        }
+
+        optional<TransportRouter::RouteItems> TransportRouter::GetRouteByStops(string_view stop_from_name, string_view stop_to_name, const SearchLimits& limits) const {
+            return FindRoute(stop_from_name, stop_to_name, MakeSearchBudget(limits));
+        }
+
+        optional<TransportRouter::RouteItems> TransportRouter::FindRoute(string_view stop_from_name, string_view stop_to_name, const graph::SearchBudget& budget) const {
+            const auto stop_from = FindStopVertex(stop_from_name);
+            const auto stop_to = FindStopVertex(stop_to_name);
+            if (!stop_from || !stop_to) {
+                return {};
+            }
+            auto router_info = BuildRoute(stop_from->wait, stop_to->wait, budget);
             if (router_info) {
-                items_info.total_time = router_info.value().weight;
-                for (const auto& edge : router_info.value().edges) {
-                    items_info.items.push_back(edge_id_to_item_.at(edge));
-                }
-                return items_info;
+                return GetRouteItems(router_info.value());
             } else {
                 return {};
             }
         }
 
+        vector<optional<TransportRouter::RouteItems>> TransportRouter::GetRoutesFromStop(string_view stop_from_name, const vector<string_view>& stop_to_names) const {
+            return FindRoutesFromStop(stop_from_name, stop_to_names, MakeSearchBudget(router_settings_.search_limits));
+        }
+
+        vector<optional<TransportRouter::RouteItems>> TransportRouter::FindRoutesFromStop(string_view stop_from_name, const vector<string_view>& stop_to_names,
+                                                                                          const graph::SearchBudget& budget) const {
+            vector<optional<RouteItems>> result;
+            result.reserve(stop_to_names.size());
+            // одиночный запрос выгоднее искать целенаправленно
+            if (router_settings_.routing_mode != RoutingMode::ON_DEMAND || (landmarks_ && stop_to_names.size() == 1)) {
+                for (string_view stop_to_name : stop_to_names) {
+                    result.push_back(FindRoute(stop_from_name, stop_to_name, budget));
+                }
+                return result;
+            }
+
+            const auto stop_from = FindStopVertex(stop_from_name);
+            // недостижимые остановки отбрасываются заранее, иначе поиск обойдёт всю компоненту в их ожидании
+            vector<optional<graph::VertexId>> targets;
+            vector<graph::VertexId> reachable_targets;
+            targets.reserve(stop_to_names.size());
+            for (string_view stop_to_name : stop_to_names) {
+                const auto stop_to = FindStopVertex(stop_to_name);
+                if (stop_from && stop_to && (!reachability_index_ || reachability_index_->IsReachable(stop_from->wait, stop_to->wait))) {
+                    targets.push_back(stop_to->wait);
+                    reachable_targets.push_back(stop_to->wait);
+                } else {
+                    targets.push_back(nullopt);
+                }
+            }
+            if (reachable_targets.empty()) {
+                result.resize(stop_to_names.size());
+                return result;
+            }
+
+            graph::ShortestPathTree<double> tree(*graph_, stop_from->wait, reachable_targets, budget);
+            for (const auto target : targets) {
+                auto router_info = target ? tree.BuildRoute(*target) : nullopt;
+                if (router_info) {
+                    result.push_back(GetRouteItems(router_info.value()));
+                } else {
+                    result.push_back(nullopt);
+                }
+            }
+            return result;
+        }
+
+        optional<TransportRouter::RouteItems> TransportRouter::GetRouteViaStops(string_view stop_from_name, const vector<string_view>& via_stop_names,
+                                                                                string_view stop_to_name) const {
+            return GetRouteViaStops(stop_from_name, via_stop_names, stop_to_name, router_settings_.search_limits);
+        }
+
+        optional<TransportRouter::RouteItems> TransportRouter::GetRouteViaStops(string_view stop_from_name, const vector<string_view>& via_stop_names,
+                                                                                string_view stop_to_name, const SearchLimits& limits) const {
+            const auto stop_names = GetRouteStopNames(stop_from_name, via_stop_names, stop_to_name);
+            if (!FindReachableStops(stop_names)) {
+                return nullopt;
+            }
+
+            map<string_view, vector<size_t>> legs_by_origin;
+            for (size_t i = 0; i + 1 < stop_names.size(); ++i) {
+                legs_by_origin[stop_names[i]].push_back(i);
+            }
+            const graph::SearchBudget budget = MakeSearchBudget(limits);
+            vector<optional<RouteItems>> legs(stop_names.size() - 1);
+            for (const auto& [origin_name, leg_indexes] : legs_by_origin) {
+                vector<string_view> stop_to_names;
+                stop_to_names.reserve(leg_indexes.size());
+                for (const size_t i : leg_indexes) {
+                    stop_to_names.push_back(stop_names[i + 1]);
+                }
+                auto routes = FindRoutesFromStop(origin_name, stop_to_names, budget);
+                for (size_t i = 0; i < leg_indexes.size(); ++i) {
+                    legs[leg_indexes[i]] = move(routes[i]);
+                }
+            }
+            return JoinRoutes(move(legs));
+        }
+
+        optional<TransportRouter::RouteItems> TransportRouter::GetRouteAtTime(string_view stop_from_name, const vector<string_view>& via_stop_names,
+                                                                              string_view stop_to_name, double departure_time, const SearchLimits& limits) const {
+            const auto stops = FindReachableStops(GetRouteStopNames(stop_from_name, via_stop_names, stop_to_name));
+            if (!stops) {
+                return nullopt;
+            }
+
+            const graph::SearchBudget budget = MakeSearchBudget(limits);
+            RouteItems route;
+            double time = departure_time;
+            for (size_t i = 0; i + 1 < stops->size(); ++i) {
+                // ожидание зависит от автобуса, поэтому учитывается в весе ребра автобуса, а не ребра ожидания
+                const auto edge_weight = [this, time](graph::EdgeId edge_id, double weight) {
+                    if (IsWaitEdge(edge_id)) {
+                        return 0.0;
+                    }
+                    const BusProfile* profile = GetEdgeProfile(edge_id);
+                    const double wait_time = GetWaitTimeAt(profile, time + weight);
+                    return wait_time + GetBusTimeAt(edge_id, profile, time + weight + wait_time);
+                };
+                const graph::VertexId to = (*stops)[i + 1].wait;
+                const auto route_info = graph::ShortestPathTree<double>(*graph_, (*stops)[i].wait, vector<graph::VertexId>{to}, edge_weight, budget).BuildRoute(to);
+                if (!route_info) {
+                    return nullopt;
+                }
+                // путь чередует рёбра ожидания и автобусов, время ожидания известно только по следующему ребру
+                for (const graph::EdgeId edge_id : route_info->edges) {
+                    route.items.push_back(edge_id_to_item_.at(edge_id));
+                    if (IsWaitEdge(edge_id)) {
+                        continue;
+                    }
+                    const BusProfile* profile = GetEdgeProfile(edge_id);
+                    const double wait_time = GetWaitTimeAt(profile, time);
+                    const double bus_time = GetBusTimeAt(edge_id, profile, time + wait_time);
+                    route.items[route.items.size() - 2].time = wait_time;
+                    route.items.back().time = bus_time;
+                    time += wait_time + bus_time;
+                }
+            }
+            route.total_time = time - departure_time;
+            return route;
+        }
+
+        optional<TransportRouter::RouteItems> TransportRouter::JoinRoutes(vector<optional<RouteItems>>&& legs) {
+            RouteItems route;
+            for (auto& leg : legs) {
+                if (!leg) {
+                    return nullopt;
+                }
+                route.total_time += leg->total_time;
+                route.items.insert(route.items.end(), make_move_iterator(leg->items.begin()), make_move_iterator(leg->items.end()));
+            }
+            return route;
+        }
+
+        size_t TransportRouter::SetEdgeWeight(graph::EdgeId edge_id, double weight) {
+            const double old_weight = graph_->GetEdge(edge_id).weight;
+            graph_->SetEdgeWeight(edge_id, weight);
+            edge_id_to_item_.at(edge_id).time = weight;
+            return RepairRoutes(edge_id, old_weight);
+        }
+
+        size_t TransportRouter::RemoveEdge(graph::EdgeId edge_id) {
+            graph_->RemoveEdge(edge_id);
+            return RepairRoutes(edge_id, graph_->GetEdge(edge_id).weight);
+        }
+
+        size_t TransportRouter::UpdateDistances(const vector<pair<domain::StopId, domain::StopId>>& stop_pairs) {
+            // автобус, проходящий перегон в любую сторону, проходит через его начальную остановку
+            set<domain::BusIndex> buses;
+            for (const auto& [from, to] : stop_pairs) {
+                const auto stop_buses = catalogue_.GetBusesForStop(from);
+                buses.insert(stop_buses.begin(), stop_buses.end());
+            }
+            // таблица восстанавливается после каждого ребра, потому что UpdateEdge учитывает изменение одного ребра,
+            // остальные индексы перестраиваются один раз после изменения всех рёбер
+            size_t updated_routes = 0;
+            bool is_graph_changed = false;
+            for (const domain::BusIndex bus_index : buses) {
+                const domain::Bus* bus = &catalogue_.GetBusByIndex(bus_index);
+                graph::EdgeId edge_id = bus_to_first_edge_.at(bus);
+                for (const auto& bus_span : GetBusSpans(bus)) {
+                    const double time = GetBusTime(bus_span.distance);
+                    if (graph_->GetEdge(edge_id).weight != time) {
+                        if (router_) {
+                            updated_routes += SetEdgeWeight(edge_id, time);
+                        } else {
+                            graph_->SetEdgeWeight(edge_id, time);
+                            edge_id_to_item_.at(edge_id).time = time;
+                            is_graph_changed = true;
+                        }
+                    }
+                    ++edge_id;
+                }
+            }
+            if (is_graph_changed) {
+                RebuildChangedRoutes();
+            }
+            return updated_routes;
+        }
+
+        void TransportRouter::UpdateRouterSettings(int bus_wait_time, double bus_velocity) {
+            router_settings_.bus_wait_time = bus_wait_time;
+            router_settings_.bus_velocity = bus_velocity;
+            for (const auto& [stop, stop_vertex] : stop_to_stop_vertex_) {
+                // ребро ожидания остановки добавлено под номером её вершины ожидания, делённым пополам
+                const graph::EdgeId edge_id = stop_vertex.wait / 2;
+                graph_->SetEdgeWeight(edge_id, static_cast<double>(bus_wait_time));
+                edge_id_to_item_.at(edge_id).time = static_cast<double>(bus_wait_time);
+            }
+            for (const auto& [bus, first_edge] : bus_to_first_edge_) {
+                graph::EdgeId edge_id = first_edge;
+                for (const auto& bus_span : GetBusSpans(bus)) {
+                    const double time = GetBusTime(bus_span.distance);
+                    graph_->SetEdgeWeight(edge_id, time);
+                    edge_id_to_item_.at(edge_id).time = time;
+                    ++edge_id;
+                }
+            }
+            if (partition_overlay_) {
+                partition_overlay_->Customize();
+            } else {
+                BuildRouteIndex();
+            }
+        }
+
         void TransportRouter::SetRouterData(RouterData&& import_data) {
             router_settings_ = move(import_data.settings);
             graph_ = make_unique<graph::DirectedWeightedGraph<double>>(move(import_data.edges), move(import_data.incidence_lists));
-            router_ = make_unique<graph::Router<double>>(*graph_, move(import_data.routes_iternal_data));
+            if (router_settings_.routing_mode == RoutingMode::HUB_LABELS) {
+                hub_labels_ = make_unique<graph::HubLabels<double>>(*graph_, move(import_data.hub_order), move(import_data.forward_labels), move(import_data.backward_labels));
+            } else if (router_settings_.routing_mode == RoutingMode::TABLE) {
+                router_ = make_unique<graph::Router<double>>(*graph_, move(import_data.routes_iternal_data));
+            } else if (router_settings_.routing_mode == RoutingMode::PAGED_TABLE) {
+                paged_routes_table_ = make_unique<graph::PagedRoutesTable<double>>(*graph_, router_settings_.table_file_name, GetTableMemoryLimit());
+            } else {
+                if (router_settings_.routing_mode == RoutingMode::OVERLAY) {
+                    partition_overlay_ = make_unique<graph::PartitionOverlay<double>>(*graph_, move(import_data.vertex_cells), move(import_data.overlay_cells));
+                }
+                if (!import_data.landmarks.empty()) {
+                    landmarks_ = make_unique<graph::Landmarks<double>>(graph_->GetVertexCount(), move(import_data.landmarks),
+                                                                       move(import_data.weights_from_landmarks), move(import_data.weights_to_landmarks));
+                }
+                if (!import_data.components.empty()) {
+                    reachability_index_ = make_unique<graph::ReachabilityIndex>(move(import_data.components), import_data.component_count, move(import_data.component_groups),
+                                                                                move(import_data.reachability));
+                }
+            }
             stop_to_stop_vertex_ = move(import_data.stop_to_stop_vertex);
             edge_id_to_item_ = move(import_data.edge_id_to_item);
+            bus_to_first_edge_ = move(import_data.bus_to_first_edge);
+            IndexBusProfiles();
         }
 
         const RouterSettings& TransportRouter::GetRouterSettings() const {
@@ -51,7 +420,23 @@ namespace transport_catalogue {
             return router_;
         }
 
-        const std::map<const domain::Stop*, StopVertex>& TransportRouter::GetStopToStopVertexMap() const {
+        const std::unique_ptr<graph::HubLabels<double>>& TransportRouter::GetHubLabelsPtr() const {
+            return hub_labels_;
+        }
+
+        const std::unique_ptr<graph::Landmarks<double>>& TransportRouter::GetLandmarksPtr() const {
+            return landmarks_;
+        }
+
+        const std::unique_ptr<graph::ReachabilityIndex>& TransportRouter::GetReachabilityIndexPtr() const {
+            return reachability_index_;
+        }
+
+        const std::unique_ptr<graph::PartitionOverlay<double>>& TransportRouter::GetPartitionOverlayPtr() const {
+            return partition_overlay_;
+        }
+
+        const std::map<domain::StopId, StopVertex>& TransportRouter::GetStopToStopVertexMap() const {
             return stop_to_stop_vertex_;
         }
 
@@ -59,9 +444,69 @@ namespace transport_catalogue {
             return edge_id_to_item_;
         }
 
+        const std::map<const domain::Bus*, graph::EdgeId>& TransportRouter::GetBusToFirstEdgeMap() const {
+            return bus_to_first_edge_;
+        }
+
+        // Индекс точки решётки 2^16 x 2^16 на кривой Гильберта: близкие точки получают близкие индексы
+        uint64_t ComputeHilbertIndex(uint32_t x, uint32_t y) {
+            constexpr uint32_t GRID_SIZE = 1u << 16;
+            uint64_t index = 0;
+            for (uint32_t s = GRID_SIZE / 2; s > 0; s /= 2) {
+                const uint32_t rx = (x & s) > 0;
+                const uint32_t ry = (y & s) > 0;
+                index += static_cast<uint64_t>(s) * s * ((3 * rx) ^ ry);
+                if (ry == 0) {
+                    if (rx == 1) {
+                        x = s - 1 - x;
+                        y = s - 1 - y;
+                    }
+                    swap(x, y);
+                }
+            }
+            return index;
+        }
+
+        // Остановки в порядке обхода кривой Гильберта по их координатам. Соседние по карте остановки
+        // получают соседние номера вершин, поэтому обход графа и строки таблицы маршрутов лучше ложатся в кэш
+        vector<domain::StopId> GetStopsInLocalityOrder(const TransportCatalogue& catalogue) {
+            vector<domain::StopId> stops(catalogue.GetStopsCount());
+            if (stops.empty()) {
+                return stops;
+            }
+
+            const vector<double>& latitudes = catalogue.GetStopLatitudes();
+            const vector<double>& longitudes = catalogue.GetStopLongitudes();
+            const auto [min_lat, max_lat] = minmax_element(latitudes.begin(), latitudes.end());
+            const auto [min_lng, max_lng] = minmax_element(longitudes.begin(), longitudes.end());
+            const double lat_from = *min_lat;
+            const double lng_from = *min_lng;
+            const double lat_range = *max_lat - lat_from;
+            const double lng_range = *max_lng - lng_from;
+            const auto to_grid = [](double value, double range) {
+                return range > 0 ? static_cast<uint32_t>(value / range * ((1u << 16) - 1)) : 0u;
+            };
+
+            vector<pair<uint64_t, domain::StopId>> stops_with_index;
+            stops_with_index.reserve(stops.size());
+            for (domain::StopId stop = 0; stop < stops.size(); ++stop) {
+                const uint32_t x = to_grid(longitudes[stop] - lng_from, lng_range);
+                const uint32_t y = to_grid(latitudes[stop] - lat_from, lat_range);
+                stops_with_index.push_back({ComputeHilbertIndex(x, y), stop});
+            }
+            sort(stops_with_index.begin(), stops_with_index.end(), [&catalogue](const auto& lhs, const auto& rhs) {
+                return lhs.first != rhs.first ? lhs.first < rhs.first : catalogue.GetStopName(lhs.second) < catalogue.GetStopName(rhs.second);
+            });
+            for (size_t i = 0; i < stops.size(); ++i) {
+                stops[i] = stops_with_index[i].second;
+            }
+            return stops;
+        }
+
         void TransportRouter::AddStopsToGraph() {
             graph::VertexId vertex_id = 0;
-            for (const auto& [name, stop] : *catalogue_.GetStopsList()) {
+            for (const domain::StopId stop : GetStopsInLocalityOrder(catalogue_)) {
+                const string_view name = catalogue_.GetStopName(stop);
                 stop_to_stop_vertex_[stop] = {vertex_id, vertex_id + 1};
                 auto edge_id = graph_->AddEdge({vertex_id, vertex_id + 1, static_cast<double>(router_settings_.bus_wait_time)});
                 Item item;
@@ -74,11 +519,42 @@ namespace transport_catalogue {
             }
         }
 
-        void TransportRouter::AddBusEdge(const domain::Stop* from, const domain::Stop* to, string_view bus_name, int span, double distance) {
+        double TransportRouter::GetBusTime(double distance) const {
+            return distance / (router_settings_.bus_velocity * 1000 / 60);
+        }
+
+        // Перегоны автобуса в порядке добавления соответствующих рёбер в граф
+        vector<TransportRouter::BusSpan> TransportRouter::GetBusSpans(const domain::Bus* bus) const {
+            vector<BusSpan> bus_spans;
+            // расстояния между соседними остановками запрашиваются у справочника один раз
+            vector<int> forward_distances, backward_distances;
+            for (size_t i = 0; i + 1 < bus->stops.size(); ++i) {
+                forward_distances.push_back(catalogue_.GetDistance(bus->stops[i], bus->stops[i + 1]));
+                if (!bus->is_roundtrip) {
+                    backward_distances.push_back(catalogue_.GetDistance(bus->stops[i + 1], bus->stops[i]));
+                }
+            }
+            for (size_t i = 0; i + 1 < bus->stops.size(); ++i) {
+                double forward_distance = 0;
+                double backward_distance = 0;
+                for (size_t j = i; j + 1 < bus->stops.size(); ++j) {
+                    const int span = static_cast<int>(j - i + 1);
+                    forward_distance += forward_distances[j];
+                    bus_spans.push_back({bus->stops[i], bus->stops[j + 1], span, forward_distance});
+                    if (!bus->is_roundtrip){
+                        backward_distance += backward_distances[j];
+                        bus_spans.push_back({bus->stops[j + 1], bus->stops[i], span, backward_distance});
+                    }
+                }
+            }
+            return bus_spans;
+        }
+
+        void TransportRouter::AddBusEdge(domain::StopId from, domain::StopId to, string_view bus_name, int span, double distance) {
             Item item;
             item.type = "Bus"s;
             item.name = bus_name;
-            item.time = distance /(router_settings_.bus_velocity *  1000 / 60);
+            item.time = GetBusTime(distance);
             item.span_count = span;
             auto vertex_from = stop_to_stop_vertex_.at(from);
             auto vertex_to = stop_to_stop_vertex_.at(to);
@@ -87,28 +563,108 @@ namespace transport_catalogue {
         }
 
         void TransportRouter::AddRouteToGraph(const domain::Bus* bus) {
-            for (size_t i = 0; i < bus->stops.size() - 1; ++i) {
-                double forward_distance = 0;
-                double backward_distance = 0;
-                for (size_t j = i; j < bus->stops.size() - 1; ++j) {
-                    forward_distance += catalogue_.GetDistance(bus->stops[j], bus->stops[j + 1]);
-                    AddBusEdge(bus->stops[i], bus->stops[j + 1], bus->name, j - i + 1, forward_distance);
-                    if (!bus->is_roundtrip){
-                        backward_distance += catalogue_.GetDistance(bus->stops[j + 1], bus->stops[j]);
-                        AddBusEdge(bus->stops[j + 1], bus->stops[i], bus->name, j - i + 1, backward_distance);
-                    }
-                }
+            bus_to_first_edge_[bus] = graph_->GetEdgeCount();
+            for (const auto& bus_span : GetBusSpans(bus)) {
+                AddBusEdge(bus_span.from, bus_span.to, bus->name, bus_span.span, bus_span.distance);
             }
         }
 
         void TransportRouter::BuildAllRoutes() {
-            size_t stops_number = catalogue_.GetStopsList()->size();
+            size_t stops_number = catalogue_.GetStopsCount();
             graph_ = std::make_unique<graph::DirectedWeightedGraph<double>>(stops_number * 2);
             AddStopsToGraph();
-            for(const auto [name, bus] : *catalogue_.GetBusesList()) {
-                AddRouteToGraph(bus);
+            for (const domain::BusIndex bus : catalogue_.GetBusesByName()) {
+                AddRouteToGraph(&catalogue_.GetBusByIndex(bus));
+            }
+            IndexBusProfiles();
+            BuildRouteIndex();
+        }
+
+        void TransportRouter::IndexBusProfiles() {
+            edge_ranges_to_profile_.clear();
+            for (const auto& [bus, first_edge] : bus_to_first_edge_) {
+                // у автобуса из одной остановки нет рёбер, его первое ребро принадлежит следующему автобусу
+                if (bus->stops.size() < 2) {
+                    continue;
+                }
+                const auto it = router_settings_.bus_profiles.find(bus->name);
+                edge_ranges_to_profile_.push_back({first_edge, it != router_settings_.bus_profiles.end() ? &it->second : nullptr});
+            }
+            sort(edge_ranges_to_profile_.begin(), edge_ranges_to_profile_.end());
+        }
+
+        const BusProfile* TransportRouter::GetEdgeProfile(graph::EdgeId edge_id) const {
+            const auto it = upper_bound(edge_ranges_to_profile_.begin(), edge_ranges_to_profile_.end(), edge_id, [](graph::EdgeId id, const auto& range) {
+                return id < range.first;
+            });
+            return it == edge_ranges_to_profile_.begin() ? nullptr : prev(it)->second;
+        }
+
+        // рёбра ожидания добавляются в граф первыми, по одному на остановку
+        bool TransportRouter::IsWaitEdge(graph::EdgeId edge_id) const {
+            return edge_id < stop_to_stop_vertex_.size();
+        }
+
+        double TransportRouter::GetWaitTimeAt(const BusProfile* profile, double time) const {
+            if (profile && !profile->headway.IsEmpty()) {
+                return profile->headway(time) / 2;
+            }
+            return static_cast<double>(router_settings_.bus_wait_time);
+        }
+
+        double TransportRouter::GetBusTimeAt(graph::EdgeId edge_id, const BusProfile* profile, double time) const {
+            const double weight = graph_->GetEdge(edge_id).weight;
+            if (profile && !profile->velocity.IsEmpty()) {
+                // вес ребра — время в пути со скоростью bus_velocity, путь проходится со скоростью профиля в каждый момент
+                return profile->velocity.SolveIntegral(time, weight * router_settings_.bus_velocity) - time;
+            }
+            return weight;
+        }
+
+        void TransportRouter::BuildRouteIndex() {
+            if (router_settings_.routing_mode == RoutingMode::HUB_LABELS) {
+                hub_labels_ = std::make_unique<graph::HubLabels<double>>(*graph_);
+            } else if (router_settings_.routing_mode == RoutingMode::TABLE) {
+                router_ = std::make_unique<graph::Router<double>>(*graph_);
+            } else if (router_settings_.routing_mode == RoutingMode::PAGED_TABLE) {
+                // файл закрывается перед перезаписью
+                paged_routes_table_.reset();
+                graph::PagedRoutesTable<double>::Write(*graph_, router_settings_.table_file_name, GetTableMemoryLimit());
+                paged_routes_table_ = std::make_unique<graph::PagedRoutesTable<double>>(*graph_, router_settings_.table_file_name, GetTableMemoryLimit());
+            } else if (router_settings_.routing_mode == RoutingMode::OVERLAY) {
+                size_t cells_count = router_settings_.overlay_cells_count > 0
+                    ? static_cast<size_t>(router_settings_.overlay_cells_count)
+                    : static_cast<size_t>(round(sqrt(static_cast<double>(stop_to_stop_vertex_.size()))));
+                cells_count = max<size_t>(1, min(cells_count, stop_to_stop_vertex_.size()));
+                partition_overlay_ = std::make_unique<graph::PartitionOverlay<double>>(*graph_, GetVertexCells(cells_count), cells_count);
+                reachability_index_ = std::make_unique<graph::ReachabilityIndex>(*graph_);
+            } else {
+                reachability_index_ = std::make_unique<graph::ReachabilityIndex>(*graph_);
+                if (router_settings_.landmarks_count > 0) {
+                    vector<graph::VertexId> wait_vertices;
+                    wait_vertices.reserve(stop_to_stop_vertex_.size());
+                    for (const auto& [stop, stop_vertex] : stop_to_stop_vertex_) {
+                        wait_vertices.push_back(stop_vertex.wait);
+                    }
+                    sort(wait_vertices.begin(), wait_vertices.end());
+                    landmarks_ = std::make_unique<graph::Landmarks<double>>(*graph_, wait_vertices, router_settings_.landmarks_count);
+                }
+            }
+        }
+
+        size_t TransportRouter::GetTableMemoryLimit() const {
+            return static_cast<size_t>(max(router_settings_.table_memory_limit, 1)) << 20;
+        }
+
+        // Ячейки разбиения — отрезки равной длины порядка Гильберта остановок, то есть компактные области карты.
+        // Вершины ожидания и автобуса одной остановки попадают в одну ячейку
+        vector<uint32_t> TransportRouter::GetVertexCells(size_t cells_count) const {
+            const size_t stops_count = stop_to_stop_vertex_.size();
+            vector<uint32_t> vertex_cells(graph_->GetVertexCount());
+            for (graph::VertexId vertex = 0; vertex < vertex_cells.size(); ++vertex) {
+                vertex_cells[vertex] = static_cast<uint32_t>(vertex / 2 * cells_count / stops_count);
             }
-            router_ = std::make_unique<graph::Router<double>>(*graph_);
+            return vertex_cells;
         }
 
     } // transport_router
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <map>
 #include <memory>
 #include <optional>
@@ -9,7 +10,15 @@
 #include <vector>
 
 #include "graph.h"
+#include "hub_labels.h"
+#include "landmarks.h"
+#include "paged_routes_table.h"
+#include "piecewise_linear_function.h"
+#include "partition_overlay.h"
+#include "reachability_index.h"
 #include "router.h"
+#include "search_budget.h"
+#include "shortest_path_tree.h"
 #include "transport_catalogue.h"
 
 namespace transport_catalogue {
@@ -20,9 +29,48 @@ namespace transport_catalogue {
             graph::VertexId bus;
         };
 
+        // Способ ответа на запросы маршрутов: полная таблица кратчайших путей, индекс двухуровневой разметки,
+        // поиск по графу во время запроса без предварительных вычислений, поиск по оверлею ячеек разбиения
+        // или полная таблица, хранящаяся в отдельном файле и читаемая постранично
+        enum class RoutingMode {
+            TABLE,
+            HUB_LABELS,
+            ON_DEMAND,
+            OVERLAY,
+            PAGED_TABLE
+        };
+
+        // Ограничения одного поиска маршрута по графу: количество обработанных вершин и время в миллисекундах,
+        // 0 — без ограничения. Таблицы и индекс разметки отвечают без поиска, поэтому ограничения на них не влияют
+        struct SearchLimits {
+            int settle_limit = 0;
+            int time_limit = 0;
+        };
+
+        // Профиль автобуса по времени суток в минутах: интервал движения в минутах и скорость в км/ч.
+        // Ожидание автобуса с профилем интервала — половина интервала, без профиля — bus_wait_time.
+        // Пустая функция скорости — используется bus_velocity
+        struct BusProfile {
+            graph::PiecewiseLinearFunction headway;
+            graph::PiecewiseLinearFunction velocity;
+        };
+
+        inline constexpr double MINUTES_PER_DAY = 24 * 60;
+
         struct RouterSettings {
             int bus_wait_time = 0;
             double bus_velocity = 0;
+            RoutingMode routing_mode = RoutingMode::TABLE;
+            // количество ориентиров ALT для ускорения поиска в режиме ON_DEMAND
+            int landmarks_count = 0;
+            // количество ячеек разбиения в режиме OVERLAY, 0 — около корня из количества остановок
+            int overlay_cells_count = 0;
+            // файл таблицы маршрутов и ограничение памяти под её страницы в мегабайтах в режиме PAGED_TABLE
+            std::string table_file_name;
+            int table_memory_limit = 64;
+            SearchLimits search_limits;
+            // профили по названиям автобусов, учитываются только в запросах со временем отправления
+            std::map<std::string, BusProfile, std::less<>> bus_profiles;
         };
 
         struct Item {
@@ -37,10 +85,26 @@ namespace transport_catalogue {
             std::vector<graph::Edge<double>> edges;
             std::vector<graph::IncidenceList> incidence_lists;
             graph::RoutesInternalData routes_iternal_data;
-            std::map <const domain::Stop*, StopVertex> stop_to_stop_vertex;
+            std::vector<graph::VertexId> hub_order;
+            graph::HubLabels<double>::Labels forward_labels;
+            graph::HubLabels<double>::Labels backward_labels;
+            std::vector<graph::VertexId> landmarks;
+            std::vector<double> weights_from_landmarks;
+            std::vector<double> weights_to_landmarks;
+            std::vector<std::uint32_t> components;
+            size_t component_count = 0;
+            std::vector<std::uint32_t> component_groups;
+            std::vector<std::uint64_t> reachability;
+            std::vector<std::uint32_t> vertex_cells;
+            std::vector<graph::PartitionOverlay<double>::Cell> overlay_cells;
+            std::map <domain::StopId, StopVertex> stop_to_stop_vertex;
             std::map<graph::EdgeId, Item> edge_id_to_item;
+            std::map<const domain::Bus*, graph::EdgeId> bus_to_first_edge;
         };
 
+        // Остановки в порядке обхода кривой Гильберта по их координатам, при равных индексах — в порядке названий
+        std::vector<domain::StopId> GetStopsInLocalityOrder(const TransportCatalogue& catalogue);
+
         class TransportRouter {
             public:
                 struct RouteItems {
@@ -50,28 +114,105 @@ namespace transport_catalogue {
 
                 TransportRouter(const TransportCatalogue& catalogue);
                 TransportRouter(const TransportCatalogue& catalogue, const RouterSettings& settings);
+                // Копия other для catalogue с теми же остановками и автобусами, например для следующей версии справочника.
+                // Граф и индексы копируются без перестроения, автобусы сопоставляются по названиям.
+                // В режиме PAGED_TABLE копия читает тот же файл таблицы, поэтому изменять её нельзя
+                TransportRouter(const TransportCatalogue& catalogue, const TransportRouter& other);
 
+                // Запросы маршрутов бросают graph::SearchBudgetExceeded, если поиск исчерпал ограничения из настроек
+                // или переданные явно. Крайний срок отсчитывается от начала запроса
                 std::optional<RouteItems> GetRouteByStops(std::string_view stop_from_name, std::string_view stop_to_name) const;
+                std::optional<RouteItems> GetRouteByStops(std::string_view stop_from_name, std::string_view stop_to_name, const SearchLimits& limits) const;
+                // Маршруты из одной остановки в несколько: в режиме ON_DEMAND выполняется один поиск на все направления
+                std::vector<std::optional<RouteItems>> GetRoutesFromStop(std::string_view stop_from_name, const std::vector<std::string_view>& stop_to_names) const;
+                // Маршрут через промежуточные остановки в заданном порядке. Отрезки с общей начальной остановкой
+                // строятся одним поиском, маршрут с недостижимым отрезком отбрасывается до поиска
+                std::optional<RouteItems> GetRouteViaStops(std::string_view stop_from_name, const std::vector<std::string_view>& via_stop_names,
+                                                           std::string_view stop_to_name) const;
+                std::optional<RouteItems> GetRouteViaStops(std::string_view stop_from_name, const std::vector<std::string_view>& via_stop_names,
+                                                           std::string_view stop_to_name, const SearchLimits& limits) const;
+                // Маршрут при отправлении в момент departure_time (минуты от начала суток) с учётом профилей автобусов.
+                // Ищется поиском Дейкстры с зависящими от времени весами, отрезки через via строятся последовательно
+                std::optional<RouteItems> GetRouteAtTime(std::string_view stop_from_name, const std::vector<std::string_view>& via_stop_names,
+                                                         std::string_view stop_to_name, double departure_time, const SearchLimits& limits) const;
+                // Объединяет отрезки маршрута, std::nullopt — если хотя бы один отрезок не построен
+                static std::optional<RouteItems> JoinRoutes(std::vector<std::optional<RouteItems>>&& legs);
+
+                // Изменение графа без полного перестроения: в режиме TABLE таблица маршрутов восстанавливается только для пар,
+                // затронутых изменением, и возвращается количество обновлённых пар вершин. В остальных режимах возвращается 0:
+                // в режиме OVERLAY пересчитываются клики ячеек и индекс достижимости, индекс разметки в режиме HUB_LABELS,
+                // таблица в файле в режиме PAGED_TABLE, ориентиры и индекс достижимости в режиме ON_DEMAND перестраиваются целиком
+                size_t SetEdgeWeight(graph::EdgeId edge_id, double weight);
+                size_t RemoveEdge(graph::EdgeId edge_id);
+                // Пересчитывает рёбра автобусов, проходящих через перегоны stop_pairs, по расстояниям справочника маршрутизатора.
+                // Справочник после Freeze не изменяется, поэтому новые расстояния задаются в следующем справочнике,
+                // собранном из текущего (BaseRequestProcess с previous), а для него создаётся копия маршрутизатора
+                // конструктором копии и обновляется этим методом. Сначала меняются веса всех рёбер, затем индексы,
+                // кроме таблицы, перестраиваются один раз
+                size_t UpdateDistances(const std::vector<std::pair<domain::StopId, domain::StopId>>& stop_pairs);
+                // Меняет время ожидания и скорость автобусов и пересчитывает веса всех рёбер.
+                // В режиме OVERLAY разбиение сохраняется и пересчитываются только клики ячеек
+                void UpdateRouterSettings(int bus_wait_time, double bus_velocity);
 
                 void SetRouterData(RouterData&& import_data);
 
                 const RouterSettings& GetRouterSettings() const;
                 const std::unique_ptr<graph::DirectedWeightedGraph<double>>& GetGraphPtr() const;
                 const std::unique_ptr<graph::Router<double>>& GetRouterPtr() const;
-                const std::map<const domain::Stop*, StopVertex>& GetStopToStopVertexMap() const;
+                const std::unique_ptr<graph::HubLabels<double>>& GetHubLabelsPtr() const;
+                const std::unique_ptr<graph::Landmarks<double>>& GetLandmarksPtr() const;
+                const std::unique_ptr<graph::ReachabilityIndex>& GetReachabilityIndexPtr() const;
+                const std::unique_ptr<graph::PartitionOverlay<double>>& GetPartitionOverlayPtr() const;
+                const std::map<domain::StopId, StopVertex>& GetStopToStopVertexMap() const;
                 const std::map<graph::EdgeId, Item>& GetEdgeIdToItemMap() const;
+                const std::map<const domain::Bus*, graph::EdgeId>& GetBusToFirstEdgeMap() const;
 
             private:
+                struct BusSpan {
+                    domain::StopId from;
+                    domain::StopId to;
+                    int span;
+                    double distance;
+                };
+
                 const TransportCatalogue& catalogue_;
                 RouterSettings router_settings_;
                 std::unique_ptr<graph::DirectedWeightedGraph<double>> graph_;
                 std::unique_ptr<graph::Router<double>> router_;
-                std::map<const domain::Stop*, StopVertex> stop_to_stop_vertex_;
+                std::unique_ptr<graph::HubLabels<double>> hub_labels_;
+                std::unique_ptr<graph::Landmarks<double>> landmarks_;
+                std::unique_ptr<graph::ReachabilityIndex> reachability_index_;
+                std::unique_ptr<graph::PartitionOverlay<double>> partition_overlay_;
+                std::unique_ptr<graph::PagedRoutesTable<double>> paged_routes_table_;
+                std::map<domain::StopId, StopVertex> stop_to_stop_vertex_;
                 std::map<graph::EdgeId, Item> edge_id_to_item_;
+                std::map<const domain::Bus*, graph::EdgeId> bus_to_first_edge_;
+                // первые рёбра автобусов по возрастанию и их профили, nullptr — у автобуса нет профиля.
+                // Рёбра одного автобуса идут подряд и разделяют один профиль
+                std::vector<std::pair<graph::EdgeId, const BusProfile*>> edge_ranges_to_profile_;
                 
-                StopVertex GetStopVertex(const domain::Stop* stop) const;
+                StopVertex GetStopVertex(domain::StopId stop) const;
+                std::optional<StopVertex> FindStopVertex(std::string_view stop_name) const;
+                std::optional<std::vector<StopVertex>> FindReachableStops(const std::vector<std::string_view>& stop_names) const;
+                void IndexBusProfiles();
+                const BusProfile* GetEdgeProfile(graph::EdgeId edge_id) const;
+                bool IsWaitEdge(graph::EdgeId edge_id) const;
+                double GetWaitTimeAt(const BusProfile* profile, double time) const;
+                double GetBusTimeAt(graph::EdgeId edge_id, const BusProfile* profile, double time) const;
+                std::optional<graph::Router<double>::RouteInfo> BuildRoute(graph::VertexId from, graph::VertexId to, const graph::SearchBudget& budget) const;
+                std::optional<RouteItems> FindRoute(std::string_view stop_from_name, std::string_view stop_to_name, const graph::SearchBudget& budget) const;
+                std::vector<std::optional<RouteItems>> FindRoutesFromStop(std::string_view stop_from_name, const std::vector<std::string_view>& stop_to_names,
+                                                                          const graph::SearchBudget& budget) const;
+                RouteItems GetRouteItems(const graph::Router<double>::RouteInfo& route_info) const;
+                size_t RepairRoutes(graph::EdgeId edge_id, double old_weight);
+                void RebuildChangedRoutes();
+                void BuildRouteIndex();
+                std::vector<std::uint32_t> GetVertexCells(size_t cells_count) const;
+                size_t GetTableMemoryLimit() const;
                 void AddStopsToGraph();
-                void AddBusEdge(const domain::Stop* from, const domain::Stop* to, std::string_view bus_name, int span, double distance);
+                double GetBusTime(double distance) const;
+                std::vector<BusSpan> GetBusSpans(const domain::Bus* bus) const;
+                void AddBusEdge(domain::StopId from, domain::StopId to, std::string_view bus_name, int span, double distance);
                 void AddRouteToGraph(const domain::Bus* bus);
                 void BuildAllRoutes();                
         };
@@ -0,0 +1,203 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace transport_catalogue {
+
+    // Пул потоков для параллельной обработки диапазона номеров. Диапазон делится на части, которые раскладываются
+    // по очередям исполнителей; исполнитель берёт части из конца своей очереди, а опустевший — из начала чужих.
+    // Вызывающий поток тоже исполнитель, поэтому пул из одного исполнителя не создаёт потоков
+    class WorkStealingPool {
+    public:
+        // 0 — по количеству ядер
+        explicit WorkStealingPool(size_t worker_count = 0);
+        WorkStealingPool(const WorkStealingPool&) = delete;
+        WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+        ~WorkStealingPool();
+
+        size_t GetWorkerCount() const;
+
+        // Вызывает task(i) для всех i из [0, count) и ждёт завершения. Задачи одного вызова выполняются параллельно,
+        // первое выброшенное ими исключение пробрасывается после завершения остальных
+        void ParallelFor(size_t count, const std::function<void(size_t)>& task);
+
+    private:
+        // части на исполнителя: с запасом, чтобы было что забрать у медленного исполнителя
+        static constexpr size_t CHUNKS_PER_WORKER = 8;
+
+        struct Chunk {
+            size_t begin;
+            size_t end;
+        };
+
+        struct Queue {
+            std::mutex mutex;
+            std::deque<Chunk> chunks;
+        };
+
+        std::vector<std::unique_ptr<Queue>> queues_;
+        std::vector<std::thread> threads_;
+
+        std::mutex mutex_;
+        std::condition_variable work_ready_;
+        std::condition_variable work_done_;
+        // номер текущего вызова ParallelFor, по его смене потоки начинают работу
+        std::uint64_t generation_ = 0;
+        bool is_stopping_ = false;
+        const std::function<void(size_t)>* task_ = nullptr;
+        size_t busy_workers_ = 0;
+        std::atomic<size_t> remaining_ = 0;
+        std::exception_ptr exception_;
+
+        void WorkerLoop(size_t worker);
+        void RunChunks(size_t worker);
+        std::optional<Chunk> TakeChunk(size_t worker);
+    };
+
+    inline WorkStealingPool::WorkStealingPool(size_t worker_count) {
+        if (worker_count == 0) {
+            worker_count = std::max(1u, std::thread::hardware_concurrency());
+        }
+        for (size_t i = 0; i < worker_count; ++i) {
+            queues_.push_back(std::make_unique<Queue>());
+        }
+        for (size_t worker = 1; worker < worker_count; ++worker) {
+            threads_.emplace_back([this, worker] {
+                WorkerLoop(worker);
+            });
+        }
+    }
+
+    inline WorkStealingPool::~WorkStealingPool() {
+        {
+            std::lock_guard guard(mutex_);
+            is_stopping_ = true;
+        }
+        work_ready_.notify_all();
+        for (std::thread& thread : threads_) {
+            thread.join();
+        }
+    }
+
+    inline size_t WorkStealingPool::GetWorkerCount() const {
+        return queues_.size();
+    }
+
+    inline void WorkStealingPool::ParallelFor(size_t count, const std::function<void(size_t)>& task) {
+        if (count == 0) {
+            return;
+        }
+        if (threads_.empty() || count == 1) {
+            for (size_t i = 0; i < count; ++i) {
+                task(i);
+            }
+            return;
+        }
+
+        const size_t chunk_size = std::max<size_t>(1, count / (queues_.size() * CHUNKS_PER_WORKER));
+        size_t worker = 0;
+        for (size_t begin = 0; begin < count; begin += chunk_size, worker = (worker + 1) % queues_.size()) {
+            std::lock_guard guard(queues_[worker]->mutex);
+            queues_[worker]->chunks.push_back({begin, std::min(count, begin + chunk_size)});
+        }
+        {
+            std::lock_guard guard(mutex_);
+            task_ = &task;
+            remaining_ = count;
+            exception_ = nullptr;
+            busy_workers_ = threads_.size();
+            ++generation_;
+        }
+        work_ready_.notify_all();
+
+        RunChunks(0);
+
+        // задача остаётся нужна, пока её выполняет хотя бы один поток
+        std::unique_lock lock(mutex_);
+        work_done_.wait(lock, [this] {
+            return busy_workers_ == 0;
+        });
+        task_ = nullptr;
+        if (exception_) {
+            std::rethrow_exception(std::exchange(exception_, nullptr));
+        }
+    }
+
+    inline void WorkStealingPool::WorkerLoop(size_t worker) {
+        std::uint64_t seen_generation = 0;
+        for (;;) {
+            {
+                std::unique_lock lock(mutex_);
+                work_ready_.wait(lock, [this, seen_generation] {
+                    return is_stopping_ || generation_ != seen_generation;
+                });
+                if (is_stopping_) {
+                    return;
+                }
+                seen_generation = generation_;
+            }
+            RunChunks(worker);
+            {
+                std::lock_guard guard(mutex_);
+                --busy_workers_;
+            }
+            work_done_.notify_one();
+        }
+    }
+
+    inline void WorkStealingPool::RunChunks(size_t worker) {
+        while (remaining_.load() > 0) {
+            const std::optional<Chunk> chunk = TakeChunk(worker);
+            if (!chunk) {
+                // части разобраны, остальные исполнители заканчивают свои
+                return;
+            }
+            for (size_t i = chunk->begin; i < chunk->end; ++i) {
+                try {
+                    (*task_)(i);
+                } catch (...) {
+                    std::lock_guard guard(mutex_);
+                    if (!exception_) {
+                        exception_ = std::current_exception();
+                    }
+                }
+            }
+            remaining_ -= chunk->end - chunk->begin;
+        }
+    }
+
+    inline std::optional<WorkStealingPool::Chunk> WorkStealingPool::TakeChunk(size_t worker) {
+        {
+            Queue& own = *queues_[worker];
+            std::lock_guard guard(own.mutex);
+            if (!own.chunks.empty()) {
+                const Chunk chunk = own.chunks.back();
+                own.chunks.pop_back();
+                return chunk;
+            }
+        }
+        for (size_t shift = 1; shift < queues_.size(); ++shift) {
+            Queue& other = *queues_[(worker + shift) % queues_.size()];
+            std::lock_guard guard(other.mutex);
+            if (!other.chunks.empty()) {
+                const Chunk chunk = other.chunks.front();
+                other.chunks.pop_front();
+                return chunk;
+            }
+        }
+        return std::nullopt;
+    }
+
+} // namespace transport_catalogue